@@ -0,0 +1,110 @@
+#include "Autosave.hpp"
+#include "SafeFile.hpp"
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+Autosave::Autosave(const std::string &path, mode_t mode)
+  : recovery_path(path), recovery_mode(mode), writing(false),
+    stopping(false), interrupted(false), interrupting(false),
+    worker(&Autosave::run, this) {}
+
+Autosave::~Autosave() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+void Autosave::save(TextBuffer::Snapshot snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = std::make_unique<TextBuffer::Snapshot>(std::move(snapshot));
+        written.reset();
+    }
+    changed.notify_all();
+}
+
+bool Autosave::release() {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool dropped = pending != nullptr;
+    pending.reset();
+    if(writing){
+        interrupting = true;
+        changed.wait(lock, [this] { return !writing; });
+        interrupting = false;
+    }
+    written.reset();
+    return dropped || std::exchange(interrupted, false);
+}
+
+void Autosave::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return !pending && !writing; });
+}
+
+void Autosave::discard() {
+    std::unique_lock<std::mutex> lock(mutex);
+    pending.reset();
+    changed.wait(lock, [this] { return !writing; });
+    std::remove(recovery_path.c_str());
+}
+
+std::string Autosave::take_error() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::exchange(error, std::string());
+}
+
+const std::string & Autosave::path() const {
+    return recovery_path;
+}
+
+void Autosave::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        changed.wait(lock, [this] { return pending || stopping; });
+        if(stopping) return;
+        std::unique_ptr<TextBuffer::Snapshot> snapshot = std::move(pending);
+        writing = true;
+        lock.unlock();
+
+        std::string failure;
+        bool finished = true;
+        try {
+            SafeFile output(recovery_path, recovery_mode);
+            finished = write(*snapshot, output);
+            if(finished){
+                output.commit(false);
+            }
+        } catch (const std::runtime_error &e) {
+            failure = e.what();
+        }
+        lock.lock();
+        // a write starts only after save(), which emptied written
+        written = std::move(snapshot);
+        writing = false;
+        interrupted = !finished;
+        if(!failure.empty()){
+            error = failure;
+        }
+        changed.notify_all();
+    }
+}
+
+bool Autosave::write(const TextBuffer::Snapshot &snapshot, SafeFile &output) {
+    TextBuffer::View text = snapshot.view();
+    std::string block;
+    for(auto it = text.begin(); it != text.end(); ){
+        if(interrupting){
+            return false;
+        }
+        block.clear();
+        for(; it != text.end() && block.size() < WRITE_BLOCK; ++it){
+            block.push_back(*it);
+        }
+        output.write(block);
+    }
+    return true;
+}
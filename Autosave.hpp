@@ -0,0 +1,113 @@
+#ifndef AUTOSAVE_HPP
+#define AUTOSAVE_HPP
+/* Autosave.hpp
+ *
+ * Background writer that keeps a recovery copy of a TextBuffer on disk.
+ * The editor hands it Snapshots, which take constant time to make, and
+ * a worker thread writes the newest one through a SafeFile, so the
+ * editor never waits on the disk. Snapshots queued while a write is in
+ * progress replace one another; only the newest is written next.
+ *
+ * Every snapshot is destroyed on the editor's thread (by save() or
+ * release()), never on the worker, so the buffer's check for whether its
+ * list is still shared is always ordered after the worker's reads by the
+ * mutex.
+ *
+ * A snapshot shares the buffer's list, so editing the buffer while one
+ * is being written would copy the whole list. Instead, release() stops
+ * the write within a block and leaves the recovery file as it was, and
+ * the editor saves again at its next pause. A large file's recovery copy
+ * is therefore only brought up to date by a pause long enough to write
+ * it, but keystrokes never wait for more than a block.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/types.h>
+#include "TextBuffer.hpp"
+
+class SafeFile;
+
+class Autosave {
+public:
+  //EFFECTS: Starts a worker that writes snapshots to the given file,
+  //         giving it the permissions in mode. These should be those of
+  //         the file being edited, so that its recovery copy is no more
+  //         readable than it is.
+  explicit Autosave(const std::string &path, mode_t mode = 0600);
+
+  //EFFECTS: Stops the worker after any write in progress. A queued
+  //         snapshot that has not been started is dropped.
+  ~Autosave();
+
+  // disable copying
+  Autosave(const Autosave &) = delete;
+  Autosave & operator=(const Autosave &) = delete;
+
+  //MODIFIES: *this
+  //EFFECTS:  Queues the snapshot to be written, replacing any snapshot
+  //          still queued, and returns without waiting. Releases the
+  //          snapshot written last, as release() does.
+  void save(TextBuffer::Snapshot snapshot);
+
+  //MODIFIES: *this
+  //EFFECTS:  Destroys every snapshot held, so that the buffer they came
+  //          from can be modified without copying its list: drops a
+  //          queued snapshot, stops a write in progress after at most
+  //          WRITE_BLOCK characters, leaving the recovery file as it
+  //          was, and destroys the snapshot written last. Returns
+  //          whether a snapshot was dropped or stopped rather than
+  //          written, so that it should be saved again. Call this from
+  //          the thread that modifies the buffer.
+  bool release();
+
+  //MODIFIES: *this
+  //EFFECTS:  Waits until no snapshot is queued or being written.
+  void flush();
+
+  //MODIFIES: *this
+  //EFFECTS:  Drops any queued snapshot, waits for a write in progress,
+  //          and removes the recovery file.
+  void discard();
+
+  //MODIFIES: *this
+  //EFFECTS:  Returns the error from the most recent failed write, or an
+  //          empty string if there was none, and clears it.
+  std::string take_error();
+
+  //EFFECTS:  Returns the path of the recovery file.
+  const std::string & path() const;
+
+  // Number of characters written between checks for release().
+  static const int WRITE_BLOCK = 1 << 16;
+
+private:
+  std::string recovery_path;
+  mode_t recovery_mode;            // permissions of the recovery file
+  std::mutex mutex;                // guards the members below
+  std::condition_variable changed; // signaled when any of them change
+  std::unique_ptr<TextBuffer::Snapshot> pending; // next to write, if any
+  std::unique_ptr<TextBuffer::Snapshot> written; // written last, if any
+  bool writing;                    // whether the worker is writing
+  bool stopping;                   // whether the worker should exit
+  bool interrupted;                // whether a write was stopped early
+  std::atomic<bool> interrupting;  // whether to stop the write early
+  std::string error;               // error from the last failed write
+  std::thread worker;              // started last, after the state above
+
+  //EFFECTS: Writes queued snapshots until stopping is set.
+  void run();
+
+  //MODIFIES: output
+  //EFFECTS:  Writes the snapshot to output a block at a time and returns
+  //          true, or returns false as soon as interrupting is set.
+  bool write(const TextBuffer::Snapshot &snapshot, SafeFile &output);
+};
+
+#endif // AUTOSAVE_HPP
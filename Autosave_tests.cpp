@@ -0,0 +1,109 @@
+#include "Autosave.hpp"
+#include "unit_test_framework.hpp"
+#include "TestFiles.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+
+using namespace std;
+
+static const string RECOVERY = TestFiles::scratch("Autosave");
+
+TEST(test_writes_snapshot) {
+    TextBuffer tb;
+    tb.insert("hello\nworld");
+    Autosave autosave(RECOVERY);
+    autosave.save(tb.snapshot());
+    // the buffer can change while the snapshot is written
+    tb.insert('!');
+    autosave.flush();
+    ASSERT_EQUAL(TestFiles::contents(RECOVERY), "hello\nworld");
+    ASSERT_EQUAL(autosave.take_error(), "");
+
+    autosave.save(tb.snapshot());
+    autosave.flush();
+    ASSERT_EQUAL(TestFiles::contents(RECOVERY), "hello\nworld!");
+
+    autosave.discard();
+    ASSERT_FALSE(TestFiles::exists(RECOVERY));
+}
+
+TEST(test_newest_snapshot_wins) {
+    TextBuffer tb;
+    Autosave autosave(RECOVERY);
+    for (int i = 0; i < 100; ++i) {
+        tb.insert('a' + i % 26);
+        autosave.save(tb.snapshot());
+    }
+    autosave.flush();
+    ASSERT_EQUAL(TestFiles::contents(RECOVERY), tb.stringify());
+    autosave.discard();
+}
+
+TEST(test_release_stops_write) {
+    TextBuffer tb;
+    tb.insert(string(Autosave::WRITE_BLOCK * 32, 'x'));
+    remove(RECOVERY.c_str());
+    Autosave autosave(RECOVERY);
+    autosave.save(tb.snapshot());
+    // the snapshot is dropped or its write stopped, not finished
+    ASSERT_TRUE(autosave.release());
+    ASSERT_FALSE(TestFiles::exists(RECOVERY));
+    ASSERT_FALSE(autosave.release());
+    ASSERT_EQUAL(autosave.take_error(), "");
+
+    autosave.save(tb.snapshot());
+    autosave.flush();
+    ASSERT_FALSE(autosave.release());
+    ASSERT_TRUE(TestFiles::contents(RECOVERY) == tb.stringify());
+    autosave.discard();
+}
+
+TEST(test_idle_save_finishes) {
+    // femto saves when the user goes idle, waits for the next key, and
+    // only then releases the snapshot
+    TextBuffer tb;
+    tb.insert(string(Autosave::WRITE_BLOCK * 32, 'x'));
+    remove(RECOVERY.c_str());
+    Autosave autosave(RECOVERY);
+    autosave.save(tb.snapshot());
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+    while (!TestFiles::exists(RECOVERY)
+           && chrono::steady_clock::now() < deadline) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    // the key arrives after the write finished, so it is not redone
+    ASSERT_FALSE(autosave.release());
+    ASSERT_TRUE(TestFiles::contents(RECOVERY) == tb.stringify());
+    autosave.discard();
+}
+
+TEST(test_recovery_file_mode) {
+    TextBuffer tb;
+    tb.insert("secret");
+    mode_t mask = umask(0);
+    for (mode_t mode : {0600u, 0640u}) {
+        Autosave autosave(RECOVERY, mode);
+        autosave.save(tb.snapshot());
+        autosave.flush();
+        struct stat info;
+        ASSERT_EQUAL(stat(RECOVERY.c_str(), &info), 0);
+        ASSERT_EQUAL(info.st_mode & 07777, mode);
+        autosave.discard();
+    }
+    umask(mask);
+}
+
+TEST(test_reports_errors) {
+    TextBuffer tb;
+    Autosave autosave("Autosave_tests_missing/recovery");
+    autosave.save(tb.snapshot());
+    autosave.flush();
+    ASSERT_TRUE(autosave.take_error() != "");
+    ASSERT_EQUAL(autosave.take_error(), "");
+}
+
+TEST_MAIN()
@@ -0,0 +1,280 @@
+#include "ByteScan.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BYTESCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using find_fn = const char * (*)(const char *, const char *, char);
+using count_fn = std::size_t (*)(const char *, const char *, char);
+using codepoints_fn = std::size_t (*)(const char *, const char *);
+
+struct Kernels {
+    find_fn find;
+    find_fn rfind;
+    count_fn count;
+    codepoints_fn count_codepoints;
+    const char *name;
+};
+
+const char * find_scalar(const char *begin, const char *end, char c) {
+    if(begin == end) return end;
+    const void *found = std::memchr(begin, c, end - begin);
+    return found ? static_cast<const char *>(found) : end;
+}
+
+const char * rfind_scalar(const char *begin, const char *end, char c) {
+    for(const char *p = end; p != begin; ){
+        --p;
+        if(*p == c){
+            return p;
+        }
+    }
+    return end;
+}
+
+std::size_t count_scalar(const char *begin, const char *end, char c) {
+    return std::count(begin, end, c);
+}
+
+std::size_t count_codepoints_scalar(const char *begin, const char *end) {
+    std::size_t total = 0;
+    for(const char *p = begin; p != end; ++p){
+        total += (static_cast<unsigned char>(*p) & 0xC0) != 0x80;
+    }
+    return total;
+}
+
+#ifdef BYTESCAN_X86
+
+// Byte counts are accumulated in 8-bit lanes, which overflow after 255
+// blocks, and then summed with a sum-of-absolute-differences.
+const int MAX_BLOCKS = 255;
+
+__attribute__((target("sse2")))
+const char * find_sse2(const char *begin, const char *end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    const char *p = begin;
+    for(; end - p >= 16; p += 16){
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if(mask){
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return find_scalar(p, end, c);
+}
+
+__attribute__((target("sse2")))
+const char * rfind_sse2(const char *begin, const char *end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    const char *p = end;
+    for(; p - begin >= 16; p -= 16){
+        __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(p - 16));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if(mask){
+            return p - 16 + (31 - __builtin_clz(mask));
+        }
+    }
+    const char *found = rfind_scalar(begin, p, c);
+    return found == p ? end : found;
+}
+
+__attribute__((target("sse2")))
+std::size_t count_sse2(const char *begin, const char *end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    const char *p = begin;
+    std::size_t total = 0;
+    while(end - p >= 16){
+        __m128i counts = _mm_setzero_si128();
+        int blocks = std::min<std::ptrdiff_t>((end - p) / 16, MAX_BLOCKS);
+        for(int i = 0; i < blocks; i++, p += 16){
+            __m128i block =
+              _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            // matching lanes are -1, so subtracting adds one
+            counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(block, needle));
+        }
+        __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+        total += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+    }
+    return total + count_scalar(p, end, c);
+}
+
+// Continuation bytes are 0x80 to 0xBF, which are -128 to -65 as signed
+// bytes, so every other byte compares greater than -65.
+const char LAST_CONTINUATION = static_cast<char>(0xBF);
+
+__attribute__((target("sse2")))
+std::size_t count_codepoints_sse2(const char *begin, const char *end) {
+    const __m128i last = _mm_set1_epi8(LAST_CONTINUATION);
+    const char *p = begin;
+    std::size_t total = 0;
+    while(end - p >= 16){
+        __m128i counts = _mm_setzero_si128();
+        int blocks = std::min<std::ptrdiff_t>((end - p) / 16, MAX_BLOCKS);
+        for(int i = 0; i < blocks; i++, p += 16){
+            __m128i block =
+              _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(block, last));
+        }
+        __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+        total += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+    }
+    return total + count_codepoints_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const char * find_avx2(const char *begin, const char *end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char *p = begin;
+    for(; end - p >= 32; p += 32){
+        __m256i block =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if(mask){
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return find_sse2(p, end, c);
+}
+
+__attribute__((target("avx2")))
+const char * rfind_avx2(const char *begin, const char *end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char *p = end;
+    for(; p - begin >= 32; p -= 32){
+        __m256i block =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p - 32));
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if(mask){
+            return p - 32 + (31 - __builtin_clz(mask));
+        }
+    }
+    const char *found = rfind_sse2(begin, p, c);
+    return found == p ? end : found;
+}
+
+__attribute__((target("avx2")))
+std::size_t count_avx2(const char *begin, const char *end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char *p = begin;
+    std::size_t total = 0;
+    while(end - p >= 32){
+        __m256i counts = _mm256_setzero_si256();
+        int blocks = std::min<std::ptrdiff_t>((end - p) / 32, MAX_BLOCKS);
+        for(int i = 0; i < blocks; i++, p += 32){
+            __m256i block =
+              _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            counts = _mm256_sub_epi8(counts,
+                                     _mm256_cmpeq_epi8(block, needle));
+        }
+        __m256i sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+        alignas(32) std::uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sums);
+        total += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return total + count_sse2(p, end, c);
+}
+
+__attribute__((target("avx2")))
+std::size_t count_codepoints_avx2(const char *begin, const char *end) {
+    const __m256i last = _mm256_set1_epi8(LAST_CONTINUATION);
+    const char *p = begin;
+    std::size_t total = 0;
+    while(end - p >= 32){
+        __m256i counts = _mm256_setzero_si256();
+        int blocks = std::min<std::ptrdiff_t>((end - p) / 32, MAX_BLOCKS);
+        for(int i = 0; i < blocks; i++, p += 32){
+            __m256i block =
+              _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            counts = _mm256_sub_epi8(counts, _mm256_cmpgt_epi8(block, last));
+        }
+        __m256i sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+        alignas(32) std::uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sums);
+        total += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return total + count_codepoints_sse2(p, end);
+}
+
+#endif // BYTESCAN_X86
+
+Kernels select_kernels() {
+#ifdef BYTESCAN_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return {find_avx2, rfind_avx2, count_avx2, count_codepoints_avx2,
+                "avx2"};
+    }
+    if(__builtin_cpu_supports("sse2")){
+        return {find_sse2, rfind_sse2, count_sse2, count_codepoints_sse2,
+                "sse2"};
+    }
+#endif
+    return {find_scalar, rfind_scalar, count_scalar, count_codepoints_scalar,
+            "scalar"};
+}
+
+const Kernels & kernels() {
+    static const Kernels selected = select_kernels();
+    return selected;
+}
+
+} // namespace
+
+const char * ByteScan::find(const char *begin, const char *end, char c) {
+    return kernels().find(begin, end, c);
+}
+
+const char * ByteScan::rfind(const char *begin, const char *end, char c) {
+    return kernels().rfind(begin, end, c);
+}
+
+std::size_t ByteScan::count(const char *begin, const char *end, char c) {
+    return kernels().count(begin, end, c);
+}
+
+std::size_t ByteScan::count_codepoints(const char *begin, const char *end) {
+    return kernels().count_codepoints(begin, end);
+}
+
+std::string_view ByteScan::normalize_newlines(const char *begin,
+                                              const char *end,
+                                              std::string &scratch,
+                                              bool &after_cr) {
+    if(begin == end) return std::string_view();
+    bool skip_lf = after_cr && *begin == '\n';
+    after_cr = (end[-1] == '\r');
+    if(skip_lf){
+        ++begin; // LF of a CRLF split across blocks
+    }
+    const char *cr = find(begin, end, '\r');
+    if(cr == end){
+        return std::string_view(begin, end - begin);
+    }
+
+    scratch.resize(end - begin);
+    char *out = scratch.data();
+    while(true){
+        std::memcpy(out, begin, cr - begin);
+        out += cr - begin;
+        if(cr == end) break;
+        *out++ = '\n';
+        begin = cr + 1;
+        if(begin != end && *begin == '\n'){
+            ++begin;
+        }
+        cr = find(begin, end, '\r');
+    }
+    return std::string_view(scratch.data(), out - scratch.data());
+}
+
+const char * ByteScan::kernel_name() {
+    return kernels().name;
+}
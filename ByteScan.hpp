@@ -0,0 +1,58 @@
+#ifndef BYTESCAN_HPP
+#define BYTESCAN_HPP
+/* ByteScan.hpp
+ *
+ * Kernels that find or count a byte, or count UTF-8 codepoints, in a
+ * contiguous run of characters, such as a block read from a file or a
+ * string being inserted into a TextBuffer. On x86 processors these
+ * compare 16 or 32 bytes at a time with SSE2 or AVX2 instructions,
+ * chosen at runtime by what the processor supports; elsewhere they are
+ * plain loops.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace ByteScan {
+  //REQUIRES: [begin, end) is a valid range
+  //EFFECTS:  Returns a pointer to the first occurrence of c in
+  //          [begin, end), or end if there is none.
+  const char * find(const char *begin, const char *end, char c);
+
+  //REQUIRES: [begin, end) is a valid range
+  //EFFECTS:  Returns a pointer to the last occurrence of c in
+  //          [begin, end), or end if there is none.
+  const char * rfind(const char *begin, const char *end, char c);
+
+  //REQUIRES: [begin, end) is a valid range
+  //EFFECTS:  Returns the number of occurrences of c in [begin, end).
+  std::size_t count(const char *begin, const char *end, char c);
+
+  //REQUIRES: [begin, end) is a valid range
+  //EFFECTS:  Returns the number of UTF-8 codepoints that start in
+  //          [begin, end), which is the number of bytes that are not
+  //          continuation bytes (0x80 to 0xBF). Invalid sequences are
+  //          not checked for.
+  std::size_t count_codepoints(const char *begin, const char *end);
+
+  //REQUIRES: [begin, end) is a valid range, and after_cr is false for
+  //          the first block of a text and is left as set by the call
+  //          for the previous block otherwise
+  //MODIFIES: scratch, after_cr
+  //EFFECTS:  Converts the CR and CRLF line endings in a block of text to
+  //          LF and returns the result. A CRLF split between this block
+  //          and the previous one becomes a single LF. Runs between CRs
+  //          are copied whole into scratch, which the result then views.
+  //          A block without any CR is returned as is, without copying.
+  std::string_view normalize_newlines(const char *begin, const char *end,
+                                      std::string &scratch, bool &after_cr);
+
+  //EFFECTS:  Returns the name of the kernels in use: "avx2", "sse2", or
+  //          "scalar".
+  const char * kernel_name();
+}
+
+#endif // BYTESCAN_HPP
@@ -0,0 +1,183 @@
+#include "ByteScan.hpp"
+#include "unit_test_framework.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Helper: a string of length n with c at each of the given positions
+static string with_bytes(int n, char c, const vector<int> &positions) {
+    string s(n, 'x');
+    for (int pos : positions) s[pos] = c;
+    return s;
+}
+
+TEST(test_empty_range) {
+    const char *p = "abc";
+    ASSERT_TRUE(ByteScan::find(p, p, 'a') == p);
+    ASSERT_TRUE(ByteScan::rfind(p, p, 'a') == p);
+    ASSERT_EQUAL(ByteScan::count(p, p, 'a'), 0u);
+}
+
+TEST(test_find_first_and_last) {
+    string s = with_bytes(100, '\n', {3, 40, 97});
+    const char *begin = s.data();
+    const char *end = begin + s.size();
+    ASSERT_EQUAL(ByteScan::find(begin, end, '\n') - begin, 3);
+    ASSERT_EQUAL(ByteScan::rfind(begin, end, '\n') - begin, 97);
+    ASSERT_EQUAL(ByteScan::count(begin, end, '\n'), 3u);
+    ASSERT_TRUE(ByteScan::find(begin, end, 'y') == end);
+    ASSERT_TRUE(ByteScan::rfind(begin, end, 'y') == end);
+}
+
+TEST(test_match_in_tail_and_head) {
+    // matches outside the whole vector blocks
+    string s = with_bytes(70, '\r', {0, 69});
+    const char *begin = s.data();
+    const char *end = begin + s.size();
+    ASSERT_EQUAL(ByteScan::find(begin + 1, end, '\r') - begin, 69);
+    ASSERT_EQUAL(ByteScan::rfind(begin, end - 1, '\r') - begin, 0);
+    ASSERT_TRUE(ByteScan::rfind(begin + 1, end - 1, '\r') == end - 1);
+}
+
+TEST(test_high_bytes) {
+    string s = with_bytes(50, '\xff', {17, 33});
+    const char *begin = s.data();
+    const char *end = begin + s.size();
+    ASSERT_EQUAL(ByteScan::find(begin, end, '\xff') - begin, 17);
+    ASSERT_EQUAL(ByteScan::rfind(begin, end, '\xff') - begin, 33);
+    ASSERT_EQUAL(ByteScan::count(begin, end, '\xff'), 2u);
+}
+
+TEST(test_count_past_lane_overflow) {
+    // more than 255 matching blocks per lane
+    string s(100000, '\n');
+    ASSERT_EQUAL(ByteScan::count(s.data(), s.data() + s.size(), '\n'),
+                 100000u);
+}
+
+TEST(test_matches_std_algorithms) {
+    std::mt19937 rng(280);
+    std::uniform_int_distribution<int> char_dist('a', 'e');
+    string s;
+    for (int i = 0; i < 2000; ++i) s.push_back(char_dist(rng));
+    for (int trial = 0; trial < 200; ++trial) {
+        int b = std::uniform_int_distribution<int>(0, 2000)(rng);
+        int e = std::uniform_int_distribution<int>(b, 2000)(rng);
+        char c = char_dist(rng);
+        const char *begin = s.data() + b;
+        const char *end = s.data() + e;
+
+        ASSERT_EQUAL(ByteScan::find(begin, end, c) - begin,
+                     std::find(begin, end, c) - begin);
+        ASSERT_EQUAL(ByteScan::count(begin, end, c),
+                     (size_t)std::count(begin, end, c));
+        const char *last = end;
+        for (const char *p = begin; p != end; ++p) {
+            if (*p == c) last = p;
+        }
+        ASSERT_EQUAL(ByteScan::rfind(begin, end, c) - begin, last - begin);
+    }
+}
+
+TEST(test_count_codepoints) {
+    // "héllo wörld → ✓" plus enough ASCII to fill whole vector blocks
+    string s = "h\xc3\xa9llo w\xc3\xb6rld \xe2\x86\x92 \xe2\x9c\x93 "
+               "\xf0\x9f\x98\x80";
+    for (int i = 0; i < 3; ++i) s += s;
+    const char *begin = s.data();
+    const char *end = begin + s.size();
+    ASSERT_EQUAL(ByteScan::count_codepoints(begin, begin), 0u);
+    ASSERT_EQUAL(ByteScan::count_codepoints(begin, begin + 3), 2u);
+    ASSERT_EQUAL(ByteScan::count_codepoints(begin, end), 8u * 17);
+}
+
+TEST(test_count_codepoints_matches_scalar) {
+    std::mt19937 rng(280);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+    string s;
+    for (int i = 0; i < 20000; ++i) s.push_back(byte_dist(rng));
+    for (int trial = 0; trial < 200; ++trial) {
+        int b = std::uniform_int_distribution<int>(0, 20000)(rng);
+        int e = std::uniform_int_distribution<int>(b, 20000)(rng);
+        size_t expected = 0;
+        for (int i = b; i < e; ++i) {
+            expected += (static_cast<unsigned char>(s[i]) & 0xC0) != 0x80;
+        }
+        ASSERT_EQUAL(ByteScan::count_codepoints(s.data() + b, s.data() + e),
+                     expected);
+    }
+}
+
+// Helper: normalize text in blocks split at the given offsets
+static string normalize(const string &text, const vector<int> &splits) {
+    string result;
+    string scratch;
+    bool after_cr = false;
+    int from = 0;
+    vector<int> ends = splits;
+    ends.push_back(text.size());
+    for (int to : ends) {
+        result += ByteScan::normalize_newlines(text.data() + from,
+                                               text.data() + to,
+                                               scratch, after_cr);
+        from = to;
+    }
+    return result;
+}
+
+TEST(test_normalize_newlines) {
+    ASSERT_EQUAL(normalize("a\r\nb\rc\n\r", {}), "a\nb\nc\n\n");
+    ASSERT_EQUAL(normalize("\r\r\n\n", {}), "\n\n\n");
+    ASSERT_EQUAL(normalize("", {}), "");
+    // CRLF split between blocks, including by an empty block
+    ASSERT_EQUAL(normalize("a\r\nb", {2}), "a\nb");
+    ASSERT_EQUAL(normalize("a\r\nb", {2, 2}), "a\nb");
+    ASSERT_EQUAL(normalize("a\r\n\nb", {2, 3}), "a\n\nb");
+    ASSERT_EQUAL(normalize("a\r\rb", {2}), "a\n\nb");
+}
+
+TEST(test_normalize_newlines_without_cr_does_not_copy) {
+    string text = "no carriage returns\n";
+    string scratch;
+    bool after_cr = false;
+    string_view result = ByteScan::normalize_newlines(
+      text.data(), text.data() + text.size(), scratch, after_cr);
+    ASSERT_TRUE(result.data() == text.data());
+    ASSERT_EQUAL(result.size(), text.size());
+    ASSERT_TRUE(scratch.empty());
+}
+
+TEST(test_normalize_newlines_matches_whole_text) {
+    std::mt19937 rng(280);
+    std::uniform_int_distribution<int> char_dist(0, 3);
+    string text;
+    for (int i = 0; i < 5000; ++i) text.push_back("ab\r\n"[char_dist(rng)]);
+    string expected;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\r') {
+            expected.push_back(text[i]);
+        } else {
+            expected.push_back('\n');
+            if (i + 1 < text.size() && text[i + 1] == '\n') ++i;
+        }
+    }
+    for (int trial = 0; trial < 50; ++trial) {
+        vector<int> splits;
+        for (int i = 0; i < 10; ++i) {
+            splits.push_back(std::uniform_int_distribution<int>(0, 5000)(rng));
+        }
+        std::sort(splits.begin(), splits.end());
+        ASSERT_EQUAL(normalize(text, splits), expected);
+    }
+}
+
+TEST(test_kernel_name) {
+    string name = ByteScan::kernel_name();
+    ASSERT_TRUE(name == "avx2" || name == "sse2" || name == "scalar");
+}
+
+TEST_MAIN()
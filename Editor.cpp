@@ -0,0 +1,495 @@
+#include "Editor.hpp"
+#include "ByteScan.hpp"
+#include "KeyBindings.hpp"
+#include <algorithm>
+#include <clocale>
+#include <cstring>
+#include <stdexcept>
+#include <langinfo.h>
+
+Editor::Editor(const std::string &filename_in)
+  : filename(filename_in), modified(false), baseline(1),
+    work_profile(nullptr), work_stages(WORK_KINDS, 0) {
+    // edit UTF-8 text as codepoints if the locale uses UTF-8
+    std::setlocale(LC_CTYPE, "");
+    utf8 = std::strcmp(nl_langinfo(CODESET), "UTF-8") == 0;
+    text.set_utf8(utf8);
+    prompt_text.set_utf8(utf8);
+    prompt_text.set_undo_limit(0, false); // no undo for prompts
+}
+
+bool Editor::handle_edit_input(int c) {
+    if(KeyBindings::is_exit(c)){
+        return !handle_exit();
+    }
+    else if(KeyBindings::is_save(c)){
+        set_modified(!handle_save(), true);
+    }
+    else if(KeyBindings::is_goto(c)){
+        handle_goto();
+    }
+    else if(KeyBindings::is_find(c)){
+        handle_find();
+    }
+    else if(KeyBindings::is_regex_find(c)){
+        handle_regex_find();
+    }
+    else if(KeyBindings::is_regex_replace(c)){
+        handle_regex_replace();
+    }
+    else if(KeyBindings::is_cut(c)){
+        return handle_cut();
+    }
+    else if(KeyBindings::is_uncut(c)){
+        handle_uncut();
+    }
+    else if(KeyBindings::is_undo(c)){
+        handle_undo();
+    }
+    else if(KeyBindings::is_redo(c)){
+        handle_redo();
+    }
+    else if(KeyBindings::is_up(c)){
+        Profile::Timer timer = time(MOVE);
+        text.up();
+    }
+    else if(KeyBindings::is_down(c)){
+        Profile::Timer timer = time(MOVE);
+        text.down();
+    }
+    else if(KeyBindings::is_pageup(c)){
+        move_page(2 - canvas_rows());
+    }
+    else if(KeyBindings::is_pagedown(c)){
+        move_page(canvas_rows() - 2);
+    }
+    else{
+        set_modified(handle_buffer_input(text, c, KeyBindings::MIN_CHAR,
+                                         max_text_char()));
+    }
+    return true;
+}
+
+void Editor::time_work(Profile *profile, const std::vector<int> &stages) {
+    work_profile = profile;
+    work_stages = stages;
+}
+
+Profile::Timer Editor::time(Work work) const {
+    return Profile::Timer(work_profile, work_stages[work]);
+}
+
+bool Editor::handle_buffer_input(TextBuffer &buffer, int c,
+                                 int min_char, int max_char) {
+    Profile::Timer timer = time(buffer_work(c));
+    if(KeyBindings::is_refresh(c)){
+        refresh_screen(&buffer == &prompt_text);
+    }
+    else if(KeyBindings::is_delete(c)){
+        return buffer.remove();
+    }
+    else if(KeyBindings::is_backspace(c)){
+        // make sure there is a character
+        return buffer.backward() && buffer.remove();
+    }
+    else if(KeyBindings::is_left(c)){
+        buffer.backward();
+    }
+    else if(KeyBindings::is_right(c)){
+        buffer.forward();
+    }
+    else if(KeyBindings::is_home(c)){
+        buffer.move_to_row_start();
+    }
+    else if(KeyBindings::is_end(c)){
+        buffer.move_to_row_end();
+    }
+    else if(KeyBindings::is_enter(c)){
+        buffer.insert('\n'); // convert to newline
+        return true;
+    }
+    else if(KeyBindings::is_word_left(c)){
+        // skip over alphanumeric characters, then the others
+        while(is_alphanumeric(buffer) && buffer.backward());
+        while(!is_alphanumeric(buffer) && buffer.backward());
+    }
+    else if(KeyBindings::is_word_right(c)){
+        while(is_alphanumeric(buffer) && buffer.forward());
+        while(!is_alphanumeric(buffer) && buffer.forward());
+    }
+    else if(KeyBindings::is_paste(c)){
+        return insert_paste(buffer, min_char, max_char);
+    }
+    else if(KeyBindings::is_ignore(c)){
+        // do nothing
+    }
+    else if(min_char <= c && c <= max_char){
+        buffer.insert(c);
+        return true;
+    }
+    else{
+        reject_key();
+    }
+    return false;
+}
+
+int Editor::max_text_char() const {
+    return utf8 ? KeyBindings::MAX_UTF8_BYTE : KeyBindings::MAX_CHAR;
+}
+
+void Editor::move_page(int offset) {
+    Profile::Timer timer = time(MOVE);
+    // move cursor first, keeping its column; the first and last rows
+    // bound the move
+    text.seek_row_col(baseline + offset, text.get_column());
+    if(text.get_row() == 1){
+        baseline = 1;
+    }
+    else if(text.get_row() >= baseline + offset){
+        // page down at the bottom should not change view
+        baseline = text.get_row();
+    }
+}
+
+bool Editor::recenter() {
+    if(text.get_row() >= baseline
+       && text.get_row() < baseline + canvas_rows()){
+        return false;
+    }
+    baseline = std::max(1, text.get_row() - canvas_rows() / 2);
+    return true;
+}
+
+std::string Editor::clear_line(TextBuffer &buffer) {
+    std::string line;
+    buffer.move_to_row_start();
+    int begin = buffer.get_index();
+    buffer.move_to_row_end();
+    int end = buffer.get_index();
+    if(!buffer.is_at_end()){
+        ++end; // include the newline that ends the row
+    }
+    buffer.remove_range(begin, end, &line);
+    return line;
+}
+
+std::string Editor::shorten_string(const std::string &original,
+                                   std::size_t limit) {
+    std::string result = original;
+    if(original.size() > limit){
+        result = "...";
+        result += original.substr(original.size() - limit + result.size());
+    }
+    return result;
+}
+
+void Editor::prompt(const std::string &, const std::string &) {
+    prompt_text.remove_range(0, prompt_text.size());
+}
+
+void Editor::set_modified(bool modify, bool force_overwrite) {
+    if(modify){
+        modified = true;
+    }
+    else if(force_overwrite){
+        modified = false;
+    }
+}
+
+void Editor::set_message(const std::string &, const std::string &) {}
+
+void Editor::show_prompt() {}
+
+void Editor::show_minibuffer() {}
+
+void Editor::show_changes() {
+    recenter();
+}
+
+void Editor::refresh_screen(bool) {}
+
+void Editor::reject_key() {}
+
+void Editor::load_rows(int) {}
+
+void Editor::load_all() {}
+
+Editor::Work Editor::buffer_work(int c) {
+    if(KeyBindings::is_delete(c) || KeyBindings::is_backspace(c)){
+        return REMOVE;
+    }
+    else if(KeyBindings::is_left(c) || KeyBindings::is_right(c)
+            || KeyBindings::is_home(c) || KeyBindings::is_end(c)
+            || KeyBindings::is_word_left(c)
+            || KeyBindings::is_word_right(c)){
+        return MOVE;
+    }
+    return INSERT;
+}
+
+bool Editor::is_alphanumeric(const TextBuffer &buffer) {
+    if(buffer.is_at_end()){
+        return false;
+    }
+    char c = buffer.data_at_cursor();
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+      || (c >= '0' && c <= '9');
+}
+
+bool Editor::insert_paste(TextBuffer &buffer, int min_char, int max_char) {
+    std::string raw = read_paste();
+    // terminals send CR for line endings
+    std::string scratch;
+    bool after_cr = false;
+    std::string paste(ByteScan::normalize_newlines(
+                        raw.data(), raw.data() + raw.size(),
+                        scratch, after_cr));
+    if(&buffer == &prompt_text){
+        paste.erase(std::min(paste.find('\n'), paste.size())); // one line
+    }
+    // drop what could not be typed, as typing it would be rejected
+    paste.erase(std::remove_if(paste.begin(), paste.end(), [=](char c) {
+                    int key = static_cast<unsigned char>(c);
+                    return key < min_char || key > max_char;
+                }), paste.end());
+    buffer.insert(paste);
+    return !paste.empty();
+}
+
+bool Editor::get_minibuffer_input(int min_char, int max_char) {
+    show_prompt();
+    int input;
+    while(!KeyBindings::is_enter(input = read_key())
+          && !KeyBindings::is_cancel(input)){
+        handle_buffer_input(prompt_text, input, min_char, max_char);
+        show_minibuffer();
+    }
+    if(KeyBindings::is_cancel(input)){
+        clear_line(prompt_text);
+        return false;
+    }
+    return true;
+}
+
+bool Editor::handle_save() {
+    prompt("File to write (^N to cancel): ", "Save as: ");
+    prompt_text.insert(filename); // start from the current name
+    get_minibuffer_input(KeyBindings::MIN_CHAR, max_text_char());
+    std::string file_to_write = prompt_text.stringify();
+    if(file_to_write.empty()){
+        set_message("Canceled", "Canceled");
+        return !modified;
+    }
+    Profile::Timer timer = time(SAVE);
+    if(!write_file(file_to_write)){
+        return !modified;
+    }
+    filename = file_to_write;
+    return true;
+}
+
+bool Editor::handle_exit() {
+    if(!modified){
+        return true;
+    }
+    prompt("Save modified buffer before exiting? (Y)es/(N)o/(C)ancel ",
+           "Save? (Y/N/C) ");
+    show_prompt();
+    while(true){
+        int c = read_key();
+        if(c == 'y' || c == 'Y'){
+            return handle_save();
+        }
+        else if(c == 'n' || c == 'N'){
+            return true;
+        }
+        else if(c == 'c' || c == 'C' || KeyBindings::is_cancel(c)){
+            set_message("Canceled", "Canceled");
+            return false;
+        }
+        reject_key();
+    }
+}
+
+void Editor::handle_goto() {
+    prompt("Goto line (^N to cancel): ", "Goto: ");
+    get_minibuffer_input('0', '9');
+    std::string input = prompt_text.stringify();
+    if(input.empty()){
+        set_message("Canceled", "Canceled");
+        return;
+    }
+    try {
+        int target = std::stoi(input);
+        Profile::Timer timer = time(MOVE);
+        load_rows(target);
+        text.seek_row_col(target, 0);
+    } catch (const std::out_of_range &) {
+        set_message("ERROR: Invalid integer", "Invalid integer");
+    }
+}
+
+void Editor::handle_find() {
+    std::string prefix = "Search (^N to cancel)";
+    if(!previous_search.empty()){
+        prefix += " [" + previous_search + "]: ";
+    }
+    else{
+        prefix += ": ";
+    }
+    prompt(prefix, "Search: ");
+    if(!get_minibuffer_input(KeyBindings::MIN_CHAR, max_text_char())){
+        set_message("Canceled", "Canceled");
+        return;
+    }
+    std::string search = prompt_text.stringify();
+    if(search.empty() && previous_search.empty()){
+        set_message("Canceled", "Canceled");
+        return;
+    }
+    else if(search.empty()){
+        search = previous_search;
+    }
+    previous_search = search;
+    go_to_match(search, [&](int from_index) {
+        return text.find(search, from_index);
+    });
+}
+
+template <typename Finder>
+void Editor::go_to_match(const std::string &search, Finder find) {
+    Profile::Timer timer = time(SEARCH);
+    load_all();
+    int old_index = text.get_index();
+    int found = find(old_index + 1);
+    if(found == -1){
+        found = find(0);
+        if(found == -1 || found > old_index){
+            set_message("\"" + shorten_string(search) + "\" not found",
+                        "Not found");
+            return;
+        }
+    }
+    text.seek_index(found);
+    if(found <= old_index){
+        set_message("Search wrapped", "Search wrapped");
+    }
+    else{
+        set_message("", "");
+    }
+}
+
+Regex * Editor::get_regex(const std::string &long_prompt,
+                          const std::string &short_prompt) {
+    std::string prefix = long_prompt + " (^N to cancel)";
+    if(!previous_regex.empty()){
+        prefix += " [" + previous_regex + "]: ";
+    }
+    else{
+        prefix += ": ";
+    }
+    prompt(prefix, short_prompt);
+    if(!get_minibuffer_input(KeyBindings::MIN_CHAR, max_text_char())){
+        set_message("Canceled", "Canceled");
+        return nullptr;
+    }
+    std::string pattern = prompt_text.stringify();
+    if(pattern.empty() && previous_regex.empty()){
+        set_message("Canceled", "Canceled");
+        return nullptr;
+    }
+    else if(pattern.empty()){
+        pattern = previous_regex;
+    }
+    if(!regex || pattern != previous_regex){
+        try {
+            regex = std::make_unique<Regex>(pattern);
+        } catch (const std::invalid_argument &error) {
+            set_message(std::string("ERROR: ") + error.what(),
+                        "Invalid regex");
+            return nullptr;
+        }
+        previous_regex = pattern;
+    }
+    return regex.get();
+}
+
+void Editor::handle_regex_find() {
+    Regex *pattern = get_regex("Regex search", "Regex: ");
+    if(pattern){
+        go_to_match(previous_regex, [&](int from_index) {
+            return text.find(*pattern, from_index);
+        });
+    }
+}
+
+void Editor::handle_regex_replace() {
+    Regex *pattern = get_regex("Replace regex", "Replace: ");
+    if(!pattern){
+        return;
+    }
+    prompt("Replace with (^N to cancel): ", "With: ");
+    if(!get_minibuffer_input(KeyBindings::MIN_CHAR, max_text_char())){
+        set_message("Canceled", "Canceled");
+        return;
+    }
+    std::string replacement = prompt_text.stringify();
+    Profile::Timer timer = time(REPLACE);
+    load_all();
+    int count = text.replace_ranges(text.find_all(*pattern), replacement);
+    set_modified(count > 0);
+    std::string replaced = "Replaced " + std::to_string(count);
+    set_message(replaced + (count == 1 ? " match" : " matches"), replaced);
+}
+
+bool Editor::handle_cut() {
+    std::string new_cut_value;
+    int input = KeyBindings::CUT;
+    while(KeyBindings::is_cut(input)){
+        std::string line;
+        {
+            Profile::Timer timer = time(CUT);
+            line = clear_line(text);
+        }
+        if(line.empty()){
+            set_message("Nothing to cut", "Nothing to cut");
+        }
+        new_cut_value += line;
+        set_modified(!new_cut_value.empty()); // update status before
+        show_changes();                       // showing the text
+        input = read_key();
+    }
+    if(!new_cut_value.empty()){
+        cut_value = new_cut_value;
+    }
+    return handle_edit_input(input); // handle the key after the cuts
+}
+
+void Editor::handle_uncut() {
+    Profile::Timer timer = time(INSERT);
+    text.insert(cut_value);
+    set_modified(!cut_value.empty());
+    if(cut_value.empty()){
+        set_message("Nothing to uncut", "Nothing to uncut");
+    }
+}
+
+void Editor::handle_undo() {
+    Profile::Timer timer = time(UNDO);
+    if(text.undo()){
+        set_modified();
+    }
+    else{
+        set_message("Nothing to undo", "Nothing to undo");
+    }
+}
+
+void Editor::handle_redo() {
+    Profile::Timer timer = time(UNDO);
+    if(text.redo()){
+        set_modified();
+    }
+    else{
+        set_message("Nothing to redo", "Nothing to redo");
+    }
+}
@@ -0,0 +1,252 @@
+#ifndef EDITOR_HPP
+#define EDITOR_HPP
+/* Editor.hpp
+ *
+ * FEMTO's commands: what each key does to the text and to the
+ * minibuffer that prompts read into, including the keys typed at the
+ * prompts. Nothing here draws or reads input. A derived class supplies
+ * the keys, and shows the prompts and messages, through the hooks
+ * below. femto.exe derives a curses editor from it, and replay.exe a
+ * replay of a key log, so that both interpret keys the same way.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Profile.hpp"
+#include "Regex.hpp"
+#include "TextBuffer.hpp"
+
+class Editor {
+public:
+  //EFFECTS: Creates an editor of an empty text with the given file name,
+  //         which is empty for a new file. Text is edited as UTF-8 if
+  //         the locale uses it.
+  explicit Editor(const std::string &filename);
+
+  virtual ~Editor() = default;
+
+  // disable copying
+  Editor(const Editor &) = delete;
+  Editor & operator=(const Editor &) = delete;
+
+  //MODIFIES: *this
+  //EFFECTS:  Handles a key typed in the text, reading any more keys that
+  //          it prompts for. Returns whether or not editing continues,
+  //          i.e. the key did not exit.
+  virtual bool handle_edit_input(int c);
+
+protected:
+  // Kinds of work done by commands, which a derived class may time.
+  enum Work {
+    INSERT, REMOVE, MOVE, SEARCH, REPLACE, CUT, UNDO, SAVE, WORK_KINDS
+  };
+
+  static const std::size_t MAX_SHORT_STRING_LENGTH = 20;
+
+  TextBuffer text;        // the text being edited
+  TextBuffer prompt_text; // input typed at a prompt, in the minibuffer
+  std::string filename;   // file the text is saved to, or empty
+  bool modified;          // whether the text has unsaved changes
+  bool utf8;              // whether text is UTF-8, from the locale
+  int baseline;           // row of the text at the top of the screen
+  std::string cut_value;
+  std::string previous_search;
+  std::string previous_regex;
+  std::unique_ptr<Regex> regex; // compiled previous_regex, keeping its
+                                // DFA cache between searches
+
+  //REQUIRES: stages has WORK_KINDS entries
+  //MODIFIES: *this
+  //EFFECTS:  Times each kind of work as the stage of profile given for
+  //          it in stages. A null profile times nothing.
+  void time_work(Profile *profile, const std::vector<int> &stages);
+
+  //EFFECTS:  Returns a timer for the given kind of work.
+  Profile::Timer time(Work work) const;
+
+  //MODIFIES: *this
+  //EFFECTS:  Handles a key typed in the given buffer, which is text or
+  //          prompt_text, inserting it if it is a character from
+  //          min_char to max_char. Returns whether or not the buffer was
+  //          modified.
+  bool handle_buffer_input(TextBuffer &buffer, int c,
+                           int min_char, int max_char);
+
+  //EFFECTS:  Returns the largest key that is inserted as text. In UTF-8
+  //          mode, this includes the bytes of encoded codepoints.
+  int max_text_char() const;
+
+  //MODIFIES: *this
+  //EFFECTS:  Moves the cursor and the baseline by offset rows, as paging
+  //          up or down does.
+  void move_page(int offset);
+
+  //MODIFIES: *this
+  //EFFECTS:  Moves the baseline by half the screen if the cursor is off
+  //          the screen. Returns whether or not the baseline moved.
+  bool recenter();
+
+  //MODIFIES: buffer
+  //EFFECTS:  Removes the cursor row, with its newline, from the buffer
+  //          and returns it.
+  static std::string clear_line(TextBuffer &buffer);
+
+  //EFFECTS:  Returns original, or its end after "..." if it is longer
+  //          than limit, e.g. for file names in messages.
+  static std::string shorten_string(
+    const std::string &original,
+    std::size_t limit = MAX_SHORT_STRING_LENGTH);
+
+  //MODIFIES: *this
+  //EFFECTS:  Empties the minibuffer to read a prompt's answer into. The
+  //          prefixes are shown before it on wide and narrow screens.
+  virtual void prompt(const std::string &long_prefix,
+                      const std::string &short_prefix);
+
+  //MODIFIES: *this
+  //EFFECTS:  Marks the text as modified if modify is true, or as
+  //          unmodified if force_overwrite is true.
+  virtual void set_modified(bool modify = true,
+                            bool force_overwrite = false);
+
+  //EFFECTS:  Shows a message about a command; short_message is for
+  //          narrow screens. Does nothing by default.
+  virtual void set_message(const std::string &long_message,
+                           const std::string &short_message);
+
+  //EFFECTS:  Shows the prompt that was started, when reading its answer
+  //          starts. Does nothing by default.
+  virtual void show_prompt();
+
+  //EFFECTS:  Shows the minibuffer after a key typed at a prompt. Does
+  //          nothing by default.
+  virtual void show_minibuffer();
+
+  //EFFECTS:  Shows the text after each line cut, while more cuts may
+  //          follow. Recenters by default.
+  virtual void show_changes();
+
+  //EFFECTS:  Redraws the screen, e.g. after it was garbled; prompting
+  //          is whether the minibuffer has the input. Does nothing by
+  //          default.
+  virtual void refresh_screen(bool prompting);
+
+  //EFFECTS:  Alerts the user to a key that was rejected. Does nothing by
+  //          default.
+  virtual void reject_key();
+
+  //MODIFIES: *this
+  //EFFECTS:  Loads the file up to the given row, if it is still being
+  //          loaded. Does nothing by default.
+  virtual void load_rows(int rows);
+
+  //MODIFIES: *this
+  //EFFECTS:  Loads the rest of the file, if it is still being loaded.
+  //          Does nothing by default.
+  virtual void load_all();
+
+  //MODIFIES: *this
+  //EFFECTS:  Returns the next key, e.g. at a prompt.
+  virtual int read_key() = 0;
+
+  //MODIFIES: *this
+  //EFFECTS:  Returns the text of the paste that a paste key started,
+  //          as the terminal sent it.
+  virtual std::string read_paste() = 0;
+
+  //MODIFIES: *this
+  //EFFECTS:  Writes the text to the named file, reporting the outcome
+  //          with set_message(). Returns whether or not it was written.
+  virtual bool write_file(const std::string &file_to_write) = 0;
+
+  //EFFECTS:  Returns the number of rows of text on the screen.
+  virtual int canvas_rows() const = 0;
+
+private:
+  Profile *work_profile;        // times work, if not null
+  std::vector<int> work_stages; // the stage of each kind of work
+
+  //EFFECTS: Returns the kind of work a key typed in a buffer does.
+  static Work buffer_work(int c);
+
+  //EFFECTS: Returns whether the cursor is over a letter or digit.
+  static bool is_alphanumeric(const TextBuffer &buffer);
+
+  //MODIFIES: *this
+  //EFFECTS:  Reads a paste and inserts what can be typed of it into the
+  //          buffer; the minibuffer takes only its first line. Returns
+  //          whether or not anything was inserted.
+  bool insert_paste(TextBuffer &buffer, int min_char, int max_char);
+
+  //MODIFIES: *this
+  //EFFECTS:  Reads an answer into the minibuffer until enter or cancel.
+  //          Returns whether or not it was entered rather than canceled,
+  //          which empties the minibuffer.
+  bool get_minibuffer_input(int min_char, int max_char);
+
+  //MODIFIES: *this
+  //EFFECTS:  Prompts for a file name, starting from the current one, and
+  //          writes the text to it, which renames the text. Returns
+  //          whether or not the text counts as saved.
+  bool handle_save();
+
+  //MODIFIES: *this
+  //EFFECTS:  Asks whether to save modified text before exiting. Returns
+  //          whether or not to exit.
+  bool handle_exit();
+
+  //MODIFIES: *this
+  //EFFECTS:  Prompts for a line number and goes to the start of it.
+  void handle_goto();
+
+  //MODIFIES: *this
+  //EFFECTS:  Prompts for a string and goes to its next match.
+  void handle_find();
+
+  //MODIFIES: *this
+  //EFFECTS:  Goes to the first match after the cursor, wrapping around
+  //          to the start of the text. find returns the index of the
+  //          first match at or after the given index, or -1.
+  template <typename Finder>
+  void go_to_match(const std::string &search, Finder find);
+
+  //MODIFIES: *this
+  //EFFECTS:  Prompts for a regular expression and returns it compiled,
+  //          reusing the previous one if it is the same, or returns null
+  //          if the prompt is canceled or the expression is invalid.
+  Regex * get_regex(const std::string &long_prompt,
+                    const std::string &short_prompt);
+
+  //MODIFIES: *this
+  //EFFECTS:  Prompts for a regular expression and goes to its next
+  //          match.
+  void handle_regex_find();
+
+  //MODIFIES: *this
+  //EFFECTS:  Prompts for a regular expression and a replacement, and
+  //          replaces every match in one batch.
+  void handle_regex_replace();
+
+  //MODIFIES: *this
+  //EFFECTS:  Removes the cursor row as long as CUT is typed, keeping the
+  //          rows in cut_value, then handles the key that follows and
+  //          returns the result.
+  bool handle_cut();
+
+  //MODIFIES: *this
+  //EFFECTS:  Inserts cut_value at the cursor.
+  void handle_uncut();
+
+  //MODIFIES: *this
+  //EFFECTS:  Reverts the most recent run of edits.
+  void handle_undo();
+
+  //MODIFIES: *this
+  //EFFECTS:  Reapplies the most recently undone run of edits.
+  void handle_redo();
+};
+
+#endif // EDITOR_HPP
@@ -0,0 +1,146 @@
+#include "Editor.hpp"
+#include "KeyBindings.hpp"
+#include "unit_test_framework.hpp"
+
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Helper: an editor that reads its keys from a script and records the
+// files it would write
+class ScriptedEditor : public Editor {
+public:
+    vector<string> writes; // names of the files written, in order
+    string paste;          // text sent by a paste key
+
+    explicit ScriptedEditor(const string &filename_in = "")
+      : Editor(filename_in) {}
+
+    // Type the given keys, as handle_edit_input() reads them. Returns
+    // whether or not editing continues.
+    bool type(const vector<int> &keys) {
+        script.insert(script.end(), keys.begin(), keys.end());
+        bool editing = true;
+        while (editing && !script.empty()) {
+            int c = script.front();
+            script.pop_front();
+            editing = handle_edit_input(c);
+        }
+        return editing;
+    }
+
+    // Type each character of the given text.
+    bool type_text(const string &chars) {
+        return type(vector<int>(chars.begin(), chars.end()));
+    }
+
+    string contents() const { return text.stringify(); }
+    const string & file() const { return filename; }
+    bool is_modified() const { return modified; }
+
+private:
+    deque<int> script;
+
+    int read_key() override {
+        if (script.empty()) {
+            throw runtime_error("script ran out of keys");
+        }
+        int c = script.front();
+        script.pop_front();
+        return c;
+    }
+
+    string read_paste() override { return paste; }
+
+    bool write_file(const string &file_to_write) override {
+        writes.push_back(file_to_write);
+        return true;
+    }
+
+    int canvas_rows() const override { return 10; }
+};
+
+TEST(test_typing) {
+    ScriptedEditor editor;
+    ASSERT_TRUE(editor.type_text("hi\rthere"));
+    ASSERT_EQUAL(editor.contents(), "hi\nthere");
+    ASSERT_TRUE(editor.is_modified());
+    ASSERT_TRUE(editor.type({KeyBindings::BACKSPACE2}));
+    ASSERT_EQUAL(editor.contents(), "hi\nther");
+}
+
+TEST(test_save_as_renames) {
+    ScriptedEditor editor("a.txt");
+    editor.type_text("x");
+    editor.type({KeyBindings::SAVE2, '2', '\r'});
+    ASSERT_EQUAL(editor.file(), "a.txt2");
+    ASSERT_FALSE(editor.is_modified());
+    // the next prompt starts from the new name
+    editor.type({KeyBindings::SAVE2, '\r'});
+    ASSERT_EQUAL(editor.writes.size(), 2u);
+    ASSERT_EQUAL(editor.writes[1], "a.txt2");
+}
+
+TEST(test_canceled_save) {
+    ScriptedEditor editor("a.txt");
+    editor.type_text("x");
+    editor.type({KeyBindings::SAVE2, 'b', KeyBindings::CANCEL});
+    ASSERT_TRUE(editor.writes.empty());
+    ASSERT_EQUAL(editor.file(), "a.txt");
+    ASSERT_TRUE(editor.is_modified());
+}
+
+TEST(test_exit) {
+    ScriptedEditor unmodified;
+    ASSERT_FALSE(unmodified.type({KeyBindings::EXIT1}));
+
+    ScriptedEditor editor("a.txt");
+    editor.type_text("x");
+    // rejected keys are asked again, and cancel keeps editing
+    ASSERT_TRUE(editor.type({KeyBindings::EXIT1, 'q', 'c'}));
+    ASSERT_FALSE(editor.type({KeyBindings::EXIT1, 'y', '\r'}));
+    ASSERT_EQUAL(editor.writes.size(), 1u);
+}
+
+TEST(test_cut_and_uncut) {
+    ScriptedEditor editor;
+    editor.type_text("one\rtwo\rthree");
+    editor.type({KeyBindings::GOTO, '1', '\r'});
+    // the key after a run of cuts is handled as usual
+    editor.type({KeyBindings::CUT, KeyBindings::CUT, 'X'});
+    ASSERT_EQUAL(editor.contents(), "Xthree");
+    // the rows cut in one run are pasted together
+    editor.type({KeyBindings::UNCUT, KeyBindings::UNCUT});
+    ASSERT_EQUAL(editor.contents(), "Xone\ntwo\none\ntwo\nthree");
+}
+
+TEST(test_find_wraps) {
+    ScriptedEditor editor;
+    editor.type_text("ab ab");
+    editor.type({KeyBindings::FIND1, 'a', 'b', '\r'});
+    editor.type_text("X");
+    ASSERT_EQUAL(editor.contents(), "Xab ab");
+}
+
+TEST(test_regex_replace_undo) {
+    ScriptedEditor editor;
+    editor.type_text("cat cot");
+    editor.type({KeyBindings::REGEX_REPLACE, 'c', '.', 't', '\r',
+                 'd', 'o', 'g', '\r'});
+    ASSERT_EQUAL(editor.contents(), "dog dog");
+    // the replacements undo as one run
+    editor.type({KeyBindings::UNDO2});
+    ASSERT_EQUAL(editor.contents(), "cat cot");
+}
+
+TEST(test_paste_normalizes_newlines) {
+    ScriptedEditor editor;
+    editor.paste = "a\r\nb\rc";
+    editor.type({KeyBindings::PASTE_START});
+    ASSERT_EQUAL(editor.contents(), "a\nb\nc");
+}
+
+TEST_MAIN()
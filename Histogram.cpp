@@ -0,0 +1,127 @@
+#include "Histogram.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+
+// longest duration counted exactly, about 31 years; longer ones share
+// the last bucket
+static const long long MAX_NANOS = 1LL << 60;
+
+Histogram::Histogram()
+  : samples(0), sum(0), largest(0) {}
+
+void Histogram::add(double seconds) {
+    seconds = std::max(seconds, 0.0);
+    long long nanos = static_cast<long long>(
+      std::min(std::round(seconds * 1e9), static_cast<double>(MAX_NANOS)));
+    std::size_t bucket = bucket_of(nanos);
+    if(bucket >= buckets.size()){
+        buckets.resize(bucket + 1);
+    }
+    ++buckets[bucket];
+    ++samples;
+    sum += seconds;
+    largest = std::max(largest, seconds);
+}
+
+void Histogram::clear() {
+    buckets.clear();
+    samples = 0;
+    sum = 0;
+    largest = 0;
+}
+
+long long Histogram::count() const {
+    return samples;
+}
+
+double Histogram::total() const {
+    return sum;
+}
+
+double Histogram::max() const {
+    return largest;
+}
+
+double Histogram::percentile(double fraction) const {
+    if(samples == 0){
+        return 0;
+    }
+    long long rank = std::max(1LL, static_cast<long long>(
+                                     std::ceil(fraction * samples)));
+    long long seen = 0;
+    std::size_t bucket = 0;
+    for(; bucket < buckets.size(); ++bucket){
+        seen += buckets[bucket];
+        if(seen >= rank) break;
+    }
+    // the last nanosecond in the bucket
+    double end = (bucket_begin(bucket + 1) - 1) / 1e9;
+    return std::min(end, largest);
+}
+
+void Histogram::print(std::ostream &os) const {
+    // merge the buckets of each power of two, starting from [0, 16)
+    std::vector<long long> powers;
+    for(std::size_t bucket = 0; bucket < buckets.size(); ++bucket){
+        std::size_t power = bucket / SUB_BUCKETS;
+        power = power > 0 ? power - 1 : 0;
+        if(power >= powers.size()){
+            powers.resize(power + 1);
+        }
+        powers[power] += buckets[bucket];
+    }
+    long long most = 0;
+    for(long long power_count : powers){
+        most = std::max(most, power_count);
+    }
+    for(std::size_t power = 0; power < powers.size(); ++power){
+        if(powers[power] == 0) continue;
+        long long begin = power == 0 ? 0 : bucket_begin((power + 1)
+                                                        * SUB_BUCKETS);
+        long long end = bucket_begin((power + 2) * SUB_BUCKETS);
+        int bar = static_cast<int>((powers[power] * BAR_WIDTH + most - 1)
+                                   / most);
+        os << std::setw(10) << format(begin / 1e9) << " - "
+           << std::setw(10) << format(end / 1e9) << " "
+           << std::setw(10) << powers[power] << " "
+           << std::string(bar, '#') << "\n";
+    }
+}
+
+std::string Histogram::format(double seconds) {
+    char text[32];
+    if(seconds < 1e-6){
+        std::snprintf(text, sizeof(text), "%.0f ns", seconds * 1e9);
+    }
+    else if(seconds < 1e-3){
+        std::snprintf(text, sizeof(text), "%.1f us", seconds * 1e6);
+    }
+    else if(seconds < 1){
+        std::snprintf(text, sizeof(text), "%.2f ms", seconds * 1e3);
+    }
+    else{
+        std::snprintf(text, sizeof(text), "%.2f s", seconds);
+    }
+    return text;
+}
+
+int Histogram::bucket_of(long long nanos) {
+    // below 2 * SUB_BUCKETS, each nanosecond has its own bucket;
+    // above, the leading bits pick one of SUB_BUCKETS per power of two
+    int shift = 0;
+    while((nanos >> shift) >= 2 * SUB_BUCKETS){
+        ++shift;
+    }
+    return shift * SUB_BUCKETS + static_cast<int>(nanos >> shift);
+}
+
+long long Histogram::bucket_begin(int bucket) {
+    if(bucket < 2 * SUB_BUCKETS){
+        return bucket;
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    return static_cast<long long>(bucket % SUB_BUCKETS + SUB_BUCKETS)
+           << shift;
+}
@@ -0,0 +1,74 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+/* Histogram.hpp
+ *
+ * Distribution of durations, e.g. the time the editor takes per key.
+ * Durations are counted in log-linear buckets of nanoseconds: eight
+ * buckets for each power of two, so a percentile is reported to within
+ * one eighth of its value while the histogram stays a few kilobytes no
+ * matter how many durations it holds.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Histogram {
+public:
+  //EFFECTS: Creates an empty histogram.
+  Histogram();
+
+  //MODIFIES: *this
+  //EFFECTS:  Records a duration, in seconds. Negative durations are
+  //          recorded as zero.
+  void add(double seconds);
+
+  //MODIFIES: *this
+  //EFFECTS:  Removes all recorded durations.
+  void clear();
+
+  //EFFECTS:  Returns the number of durations recorded.
+  long long count() const;
+
+  //EFFECTS:  Returns the sum of the durations recorded, in seconds.
+  double total() const;
+
+  //EFFECTS:  Returns the longest duration recorded, in seconds, or 0 if
+  //          there are none.
+  double max() const;
+
+  //REQUIRES: 0 <= fraction <= 1
+  //EFFECTS:  Returns the duration that the given fraction of the
+  //          recorded durations do not exceed, in seconds, rounded up
+  //          to the end of its bucket but no further than max(). Returns
+  //          0 if there are none.
+  double percentile(double fraction) const;
+
+  //MODIFIES: os
+  //EFFECTS:  Writes a line per power of two that holds any durations,
+  //          with its range, count and a bar scaled to the largest count.
+  void print(std::ostream &os) const;
+
+  //EFFECTS:  Returns the duration in seconds as a short string in the
+  //          most readable unit, e.g. "12.5 us".
+  static std::string format(double seconds);
+
+private:
+  static const int SUB_BUCKETS = 8; // buckets per power of two
+  static const int BAR_WIDTH = 40;  // characters in the longest bar
+
+  std::vector<long long> buckets; // counts, grown as needed
+  long long samples;
+  double sum;
+  double largest;
+
+  //EFFECTS: Returns the bucket that holds the given nanoseconds.
+  static int bucket_of(long long nanos);
+
+  //EFFECTS: Returns the smallest number of nanoseconds in the bucket.
+  static long long bucket_begin(int bucket);
+};
+
+#endif // HISTOGRAM_HPP
@@ -0,0 +1,90 @@
+#include "Histogram.hpp"
+#include "unit_test_framework.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+TEST(test_empty) {
+    Histogram histogram;
+    ASSERT_EQUAL(histogram.count(), 0);
+    ASSERT_EQUAL(histogram.total(), 0.0);
+    ASSERT_EQUAL(histogram.max(), 0.0);
+    ASSERT_EQUAL(histogram.percentile(0.5), 0.0);
+    ostringstream output;
+    histogram.print(output);
+    ASSERT_EQUAL(output.str(), "");
+}
+
+TEST(test_counts_and_totals) {
+    Histogram histogram;
+    histogram.add(1e-6);
+    histogram.add(3e-6);
+    histogram.add(-1); // recorded as zero
+    ASSERT_EQUAL(histogram.count(), 3);
+    ASSERT_ALMOST_EQUAL(histogram.total(), 4e-6, 1e-12);
+    ASSERT_ALMOST_EQUAL(histogram.max(), 3e-6, 1e-12);
+    ASSERT_EQUAL(histogram.percentile(0), 0.0);
+
+    histogram.clear();
+    ASSERT_EQUAL(histogram.count(), 0);
+    ASSERT_EQUAL(histogram.max(), 0.0);
+}
+
+TEST(test_small_durations_are_exact) {
+    Histogram histogram;
+    for (int nanos = 1; nanos <= 10; ++nanos) {
+        histogram.add(nanos / 1e9);
+    }
+    ASSERT_ALMOST_EQUAL(histogram.percentile(0.5), 5e-9, 1e-15);
+    ASSERT_ALMOST_EQUAL(histogram.percentile(0.9), 9e-9, 1e-15);
+    ASSERT_ALMOST_EQUAL(histogram.percentile(1), 10e-9, 1e-15);
+}
+
+TEST(test_percentiles_within_an_eighth) {
+    Histogram histogram;
+    // 1 us to 1000 us, evenly
+    for (int micros = 1; micros <= 1000; ++micros) {
+        histogram.add(micros / 1e6);
+    }
+    double p50 = histogram.percentile(0.5);
+    double p99 = histogram.percentile(0.99);
+    ASSERT_TRUE(p50 >= 500e-6 && p50 <= 500e-6 * 1.125);
+    ASSERT_TRUE(p99 >= 990e-6 && p99 <= 1000e-6);
+    ASSERT_TRUE(p50 <= p99);
+    // never past the longest duration
+    ASSERT_ALMOST_EQUAL(histogram.percentile(1), 1000e-6, 1e-12);
+}
+
+TEST(test_long_durations) {
+    Histogram histogram;
+    histogram.add(1e12); // longer than the last bucket
+    histogram.add(2.5);
+    ASSERT_EQUAL(histogram.count(), 2);
+    ASSERT_TRUE(histogram.percentile(0.5) >= 2.5);
+    ASSERT_TRUE(histogram.percentile(0.5) <= 2.5 * 1.125);
+}
+
+TEST(test_print) {
+    Histogram histogram;
+    histogram.add(3e-9);
+    histogram.add(20e-9);
+    histogram.add(21e-9);
+    ostringstream output;
+    histogram.print(output);
+    // one line for [0, 16) ns and one for [16, 32) ns
+    ASSERT_EQUAL(output.str(),
+                 "      0 ns -      16 ns          1 ####################\n"
+                 "     16 ns -      32 ns          2 "
+                 "########################################\n");
+}
+
+TEST(test_format) {
+    ASSERT_EQUAL(Histogram::format(250e-9), "250 ns");
+    ASSERT_EQUAL(Histogram::format(12.5e-6), "12.5 us");
+    ASSERT_EQUAL(Histogram::format(3.25e-3), "3.25 ms");
+    ASSERT_EQUAL(Histogram::format(2), "2.00 s");
+}
+
+TEST_MAIN()
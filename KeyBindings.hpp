@@ -0,0 +1,149 @@
+#ifndef KEYBINDINGS_HPP
+#define KEYBINDINGS_HPP
+/* KeyBindings.hpp
+ *
+ * The keys FEMTO responds to, as curses reports them from getch(),
+ * shared by the editor and by the tools that replay its key logs.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <ncurses.h>
+
+struct KeyBindings {
+  static const int EXIT1 = 24; // ^X
+  static const int EXIT2 = 17; // ^Q
+  static const int SAVE1 = 1; // ^A
+  static const int SAVE2 = 19; // ^S
+  static const int SAVE3 = 15; // ^O - pico/nano binding
+  static const int REFRESH = 12; // ^L
+  static const int FIND1 = 6; // ^F
+  static const int FIND2 = 23; // ^W - pico/nano binding
+  static const int REGEX_FIND = 18; // ^R
+  static const int REGEX_REPLACE = 20; // ^T
+  static const int GOTO = 7; // ^G
+  static const int CUT = 11; // ^K
+  static const int UNCUT = 21; // ^U
+  static const int UNDO1 = 26; // ^Z (raw mode only)
+  static const int UNDO2 = 2; // ^B
+  static const int REDO = 25; // ^Y
+  static const int CANCEL = 14; // ^N
+  static const int INTERRUPT = 3; // ^C
+  static const int ESCAPE = 27;
+  static const int DELETE = 4; // ^D
+  static const int BACKSPACE2 = 127;
+  static const int BACKSPACE3 = '\b';
+  static const int NEWLINE = '\n';
+  static const int CARRIAGE_RETURN = '\r';
+  static const int WORD_LEFT1 = 542; // ^left on MacOS
+  static const int WORD_LEFT2 = 546; // ^left on Windows
+  static const int WORD_LEFT3 = 547; // ^left on MacOS (raw)
+  static const int WORD_RIGHT1 = 557; // ^right on MacOS
+  static const int WORD_RIGHT2 = 561; // ^right on Windows
+  static const int WORD_RIGHT3 = 562; // ^right on MacOS (raw)
+  static const int PAGE_DOWN = 526; // ^down on Windows
+  static const int PAGE_UP = 567; // ^up on Windows
+  static const int IGNORE1 = -1; // sent when mucking with the window
+  static const int IGNORE2 = 410; // sent when mucking with the window
+  static const int PASTE_START = KEY_MAX + 1; // defined by femto
+  static const int PASTE_END = KEY_MAX + 2;
+  static const int RECOVERED = KEY_MAX + 3; // logged when femto restores
+                                            // a recovery file
+  static const int MIN_CHAR = 1;
+  static const int MAX_CHAR = 126;
+  static const int MAX_UTF8_BYTE = 255;
+
+  static constexpr bool is_exit(int c) {
+    return c == EXIT1 || c == EXIT2 || c == INTERRUPT;
+  }
+  static constexpr bool is_save(int c) {
+    return c == SAVE1 || c == SAVE2 || c == SAVE3;
+  }
+  static constexpr bool is_refresh(int c) {
+    return c == REFRESH;
+  }
+  static constexpr bool is_goto(int c) {
+    return c == GOTO;
+  }
+  static constexpr bool is_find(int c) {
+    return c == FIND1 || c == FIND2;
+  }
+  static constexpr bool is_regex_find(int c) {
+    return c == REGEX_FIND;
+  }
+  static constexpr bool is_regex_replace(int c) {
+    return c == REGEX_REPLACE;
+  }
+  static constexpr bool is_cut(int c) {
+    return c == CUT;
+  }
+  static constexpr bool is_uncut(int c) {
+    return c == UNCUT;
+  }
+  static constexpr bool is_undo(int c) {
+    return c == UNDO1 || c == UNDO2;
+  }
+  static constexpr bool is_redo(int c) {
+    return c == REDO;
+  }
+  static constexpr bool is_cancel(int c) {
+    return c == CANCEL || c == INTERRUPT || c == ESCAPE;
+  }
+  static constexpr bool is_up(int c) {
+    return c == KEY_UP; // ncurses constant
+  }
+  static constexpr bool is_down(int c) {
+    return c == KEY_DOWN; // ncurses constant
+  }
+  static constexpr bool is_pageup(int c) {
+    return c == KEY_PPAGE /* ncurses constant */ || c == PAGE_UP;
+  }
+  static constexpr bool is_pagedown(int c) {
+    return c == KEY_NPAGE /* ncurses constant */ || c == PAGE_DOWN;
+  }
+  static constexpr bool is_enter(int c) {
+    return c == KEY_ENTER // ncurses constant
+      || c == NEWLINE || c == CARRIAGE_RETURN;
+  }
+  static constexpr bool is_backspace(int c) {
+    return c == KEY_BACKSPACE // ncurses constant
+      || c == BACKSPACE2 || c == BACKSPACE3;
+  }
+  static constexpr bool is_delete(int c) {
+    return c == KEY_DC /* ncurses constant */ || c == DELETE;
+  }
+  static constexpr bool is_left(int c) {
+    return c == KEY_LEFT; // ncurses constant
+  }
+  static constexpr bool is_right(int c) {
+    return c == KEY_RIGHT; // ncurses constant
+  }
+  static constexpr bool is_home(int c) {
+    return c == KEY_HOME; // ncurses constant
+  }
+  static constexpr bool is_end(int c) {
+    return c == KEY_END; // ncurses constant
+  }
+  static constexpr bool is_word_left(int c) {
+    return c == WORD_LEFT1 || c == WORD_LEFT2 || c == WORD_LEFT3;
+  }
+  static constexpr bool is_word_right(int c) {
+    return c == WORD_RIGHT1 || c == WORD_RIGHT2 || c == WORD_RIGHT3;
+  }
+  static constexpr bool is_ignore(int c) {
+    return c == IGNORE1 || c == IGNORE2
+      || c == PASTE_END; // end of a paste that was not started
+  }
+  static constexpr bool is_paste(int c) {
+    return c == PASTE_START;
+  }
+  // whether the key runs a command on the text, rather than typing or
+  // moving the cursor
+  static constexpr bool is_command(int c) {
+    return is_exit(c) || is_save(c) || is_goto(c) || is_find(c)
+      || is_regex_find(c) || is_regex_replace(c) || is_cut(c)
+      || is_uncut(c) || is_undo(c) || is_redo(c);
+  }
+};
+
+#endif // KEYBINDINGS_HPP
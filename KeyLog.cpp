@@ -0,0 +1,138 @@
+#include "KeyLog.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+static const char MAGIC[] = "FKL1";
+static const std::size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+static const int VARINT_BITS = 7;
+static const int MAX_VARINT_SHIFT = 63;
+// longest text a log can hold
+static const unsigned long long MAX_TEXT = 1ULL << 40;
+
+KeyLogWriter::KeyLogWriter(const std::string &path)
+  : file(std::fopen(path.c_str(), "wb")), started(clock::now()),
+    logged_micros(0) {
+    if(!file){
+        throw std::runtime_error("Unable to write " + path + ": "
+                                 + std::strerror(errno));
+    }
+    std::fwrite(MAGIC, 1, MAGIC_SIZE, file);
+}
+
+KeyLogWriter::~KeyLogWriter() {
+    std::fclose(file);
+}
+
+void KeyLogWriter::key(int key) {
+    event(static_cast<unsigned long long>(key) << 1);
+}
+
+void KeyLogWriter::text(std::string_view text) {
+    event(static_cast<unsigned long long>(text.size()) << 1 | 1);
+    std::fwrite(text.data(), 1, text.size(), file);
+}
+
+void KeyLogWriter::flush() {
+    std::fflush(file);
+}
+
+void KeyLogWriter::event(unsigned long long tagged) {
+    // measured from the start, so rounding never accumulates
+    long long micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                         clock::now() - started).count();
+    varint(micros - logged_micros);
+    logged_micros = micros;
+    varint(tagged);
+}
+
+void KeyLogWriter::varint(unsigned long long value) {
+    const unsigned long long low_bits = (1u << VARINT_BITS) - 1;
+    while(value > low_bits){
+        std::fputc(static_cast<int>((value & low_bits) | (low_bits + 1)),
+                   file);
+        value >>= VARINT_BITS;
+    }
+    std::fputc(static_cast<int>(value), file);
+}
+
+KeyLogReader::KeyLogReader(const std::string &path_in)
+  : file(std::fopen(path_in.c_str(), "rb")), path(path_in),
+    read_micros(0) {
+    if(!file){
+        throw std::runtime_error("Unable to read " + path + ": "
+                                 + std::strerror(errno));
+    }
+    char magic[MAGIC_SIZE];
+    if(std::fread(magic, 1, MAGIC_SIZE, file) != MAGIC_SIZE
+       || std::memcmp(magic, MAGIC, MAGIC_SIZE) != 0){
+        std::fclose(file);
+        throw std::runtime_error(path + " is not a key log");
+    }
+}
+
+KeyLogReader::~KeyLogReader() {
+    std::fclose(file);
+}
+
+bool KeyLogReader::next(KeyEvent &event) {
+    unsigned long long delay;
+    unsigned long long tagged;
+    if(!varint(delay)){
+        return false;
+    }
+    if(!varint(tagged)){
+        corrupt();
+    }
+    read_micros += delay;
+    event.time = read_micros / 1e6;
+    event.text.clear();
+    if((tagged & 1) && (tagged >> 1) > MAX_TEXT){
+        corrupt();
+    }
+    else if(tagged & 1){
+        event.key = KeyEvent::TEXT;
+        // read in blocks, so a corrupt length fails before it is
+        // allocated
+        char block[1 << 16];
+        for(unsigned long long left = tagged >> 1; left > 0; ){
+            std::size_t size = std::min<unsigned long long>(left,
+                                                            sizeof(block));
+            if(std::fread(block, 1, size, file) != size){
+                corrupt();
+            }
+            event.text.append(block, size);
+            left -= size;
+        }
+    }
+    else if((tagged >> 1) > static_cast<unsigned long long>(
+                              std::numeric_limits<int>::max())){
+        corrupt();
+    }
+    else{
+        event.key = static_cast<int>(tagged >> 1);
+    }
+    return true;
+}
+
+bool KeyLogReader::varint(unsigned long long &value) {
+    value = 0;
+    for(int shift = 0; ; shift += VARINT_BITS){
+        int byte = std::fgetc(file);
+        if(byte == EOF){
+            if(shift == 0) return false; // between events
+            corrupt();
+        }
+        if(shift > MAX_VARINT_SHIFT){
+            corrupt();
+        }
+        value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+        if(!(byte & 0x80)) return true;
+    }
+}
+
+void KeyLogReader::corrupt() const {
+    throw std::runtime_error(path + " is cut off or corrupt");
+}
@@ -0,0 +1,110 @@
+#ifndef KEYLOG_HPP
+#define KEYLOG_HPP
+/* KeyLog.hpp
+ *
+ * Compact binary log of the keys typed in an editing session, with the
+ * time each arrived, so that real sessions can be replayed later.
+ *
+ * A log starts with the four bytes "FKL1". Each event that follows is
+ * two unsigned LEB128 varints: the microseconds since the previous
+ * event (or since the log started), then either key * 2 for a key or
+ * length * 2 + 1 for text, which is followed by that many bytes. Text
+ * holds input read along with a key rather than as keys of its own,
+ * such as the contents of a paste. A typed character takes 2 or 3
+ * bytes.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// An event read from a key log.
+struct KeyEvent {
+  static const int TEXT = -1; // key of an event that holds text
+
+  double time;      // seconds since the log started
+  int key;          // the key, or TEXT
+  std::string text; // the text, if key is TEXT
+};
+
+class KeyLogWriter {
+public:
+  //EFFECTS: Creates or replaces the named log and starts its clock.
+  //         Throws std::runtime_error if it cannot be created.
+  explicit KeyLogWriter(const std::string &path);
+
+  //EFFECTS: Writes any buffered events and closes the log.
+  ~KeyLogWriter();
+
+  // disable copying
+  KeyLogWriter(const KeyLogWriter &) = delete;
+  KeyLogWriter & operator=(const KeyLogWriter &) = delete;
+
+  //REQUIRES: key >= 0
+  //MODIFIES: *this
+  //EFFECTS:  Logs the key as arriving now.
+  void key(int key);
+
+  //MODIFIES: *this
+  //EFFECTS:  Logs the text as arriving now.
+  void text(std::string_view text);
+
+  //MODIFIES: *this
+  //EFFECTS:  Writes buffered events to the file, e.g. before waiting
+  //          for input, so that a session that crashes keeps its log.
+  void flush();
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  std::FILE *file;
+  clock::time_point started;
+  long long logged_micros; // time of the last event since started
+
+  //MODIFIES: *this
+  //EFFECTS:  Writes the time since the last event and the tagged value.
+  void event(unsigned long long tagged);
+
+  //MODIFIES: *this
+  //EFFECTS:  Writes the value as a varint.
+  void varint(unsigned long long value);
+};
+
+class KeyLogReader {
+public:
+  //EFFECTS: Opens the named log. Throws std::runtime_error if it cannot
+  //         be read or is not a key log.
+  explicit KeyLogReader(const std::string &path);
+
+  //EFFECTS: Closes the log.
+  ~KeyLogReader();
+
+  // disable copying
+  KeyLogReader(const KeyLogReader &) = delete;
+  KeyLogReader & operator=(const KeyLogReader &) = delete;
+
+  //MODIFIES: *this, event
+  //EFFECTS:  Reads the next event into event and returns true, or
+  //          returns false at the end of the log. Throws
+  //          std::runtime_error if the log is cut off or corrupt.
+  bool next(KeyEvent &event);
+
+private:
+  std::FILE *file;
+  std::string path;
+  long long read_micros; // time of the last event read
+
+  //MODIFIES: *this
+  //EFFECTS:  Reads a varint into value and returns true, or returns
+  //          false at the end of the log. Throws std::runtime_error if
+  //          the varint is cut off or too long.
+  bool varint(unsigned long long &value);
+
+  //EFFECTS: Throws std::runtime_error describing the corrupt log.
+  [[noreturn]] void corrupt() const;
+};
+
+#endif // KEYLOG_HPP
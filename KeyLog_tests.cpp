@@ -0,0 +1,101 @@
+#include "KeyLog.hpp"
+#include "unit_test_framework.hpp"
+#include "TestFiles.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static const string LOG = TestFiles::scratch("KeyLog");
+
+// Helper: whether reading the named log to its end throws
+static bool reading_throws(const string &name) {
+    try {
+        KeyLogReader reader(name);
+        KeyEvent event;
+        while (reader.next(event));
+    } catch (const runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+TEST(test_round_trip) {
+    string paste(1000, 'x');
+    paste += "\r\n\0end";
+    {
+        KeyLogWriter writer(LOG);
+        writer.key('a');
+        writer.key(0); // keys may be zero
+        writer.key(410); // curses key codes
+        writer.text(paste);
+        writer.text("");
+        writer.key(1 << 20);
+    }
+    KeyLogReader reader(LOG);
+    KeyEvent event;
+    double last_time = 0;
+    int keys[] = {'a', 0, 410, KeyEvent::TEXT, KeyEvent::TEXT, 1 << 20};
+    string texts[] = {"", "", "", paste, "", ""};
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(reader.next(event));
+        ASSERT_EQUAL(event.key, keys[i]);
+        ASSERT_TRUE(event.text == texts[i]);
+        ASSERT_TRUE(event.time >= last_time);
+        last_time = event.time;
+    }
+    ASSERT_FALSE(reader.next(event));
+    ASSERT_FALSE(reader.next(event));
+    remove(LOG.c_str());
+}
+
+TEST(test_compact) {
+    {
+        KeyLogWriter writer(LOG);
+        for (int i = 0; i < 100; ++i) {
+            writer.key('a' + i % 26);
+        }
+    }
+    // the header, then at most 3 bytes per key typed quickly
+    ASSERT_TRUE(TestFiles::contents(LOG).size() <= 4 + 3 * 100);
+    remove(LOG.c_str());
+}
+
+TEST(test_flush) {
+    KeyLogWriter writer(LOG);
+    writer.key('q');
+    writer.flush();
+    // readable while the writer is still open
+    KeyLogReader reader(LOG);
+    KeyEvent event;
+    ASSERT_TRUE(reader.next(event));
+    ASSERT_EQUAL(event.key, 'q');
+    ASSERT_FALSE(reader.next(event));
+}
+
+TEST(test_rejects_other_files) {
+    TestFiles::write(LOG, "not a log");
+    ASSERT_TRUE(reading_throws(LOG));
+    ASSERT_TRUE(reading_throws("KeyLog_tests_missing/log"));
+    remove(LOG.c_str());
+}
+
+TEST(test_rejects_cut_off_logs) {
+    {
+        KeyLogWriter writer(LOG);
+        writer.text("some pasted text");
+    }
+    string log = TestFiles::contents(LOG);
+    for (size_t size = log.size() - 1; size > 4; --size) {
+        TestFiles::write(LOG, log.substr(0, size));
+        ASSERT_TRUE(reading_throws(LOG));
+    }
+    // a huge text length fails rather than allocating it
+    TestFiles::write(LOG, "FKL1\x01\xff\xff\xff\xff\xff\x7f");
+    ASSERT_TRUE(reading_throws(LOG));
+    remove(LOG.c_str());
+}
+
+TEST_MAIN()
@@ -354,6 +354,41 @@ public:
 
   }
 
+  //REQUIRES: first and last are valid iterators associated with this list,
+  //          and last is reachable from first
+  //MODIFIES: invalidates all iterators to the removed elements
+  //EFFECTS: Removes the elements in the range [first, last) from the list,
+  //         relinking the neighbors of the range only once.
+  //         Returns an iterator pointing to last.
+  Iterator erase(Iterator first_it, Iterator last_it){
+    if(first_it == last_it){
+      return last_it;
+    }
+    Node *p = first_it.node_ptr->prev;
+    Node *n = last_it.node_ptr;
+    Node *current = first_it.node_ptr;
+    while(current != n){
+      Node *ptr_delete = current;
+      current = current->next;
+      delete ptr_delete;
+      list_size--;
+    }
+
+    if(p){
+      p->next = n;
+    }
+    else{
+      first = n;
+    }
+    if(n){
+      n->prev = p;
+    }
+    else{
+      last = p;
+    }
+    return Iterator(this, n);
+  }
+
   //REQUIRES: i is a valid iterator associated with this list
   //EFFECTS: Inserts datum before the element at the specified position.
   //         Returns an iterator to the the newly inserted element.
@@ -372,4 +372,40 @@ TEST(test_insert_and_erase_second) {
 }
 
 
+TEST(test_erase_range) {
+    List<int> lst;
+    for (int i = 1; i <= 5; ++i) {
+        lst.push_back(i);
+    }
+
+    auto first = lst.begin();
+    ++first;
+    auto last = first;
+    ++last;
+    ++last;
+    auto it = lst.erase(first, last);
+    ASSERT_EQUAL(*it, 4);
+    ASSERT_EQUAL(lst.size(), 3);
+    vector<int> expected{1, 4, 5};
+    ASSERT_SEQUENCE_EQUAL(lst, expected);
+
+    it = lst.erase(it, it);
+    ASSERT_EQUAL(*it, 4);
+    ASSERT_EQUAL(lst.size(), 3);
+
+    it = lst.erase(it, lst.end());
+    ASSERT_TRUE(it == lst.end());
+    ASSERT_EQUAL(lst.back(), 1);
+    ASSERT_EQUAL(lst.size(), 1);
+
+    lst.push_back(2);
+    it = lst.erase(lst.begin(), lst.end());
+    ASSERT_TRUE(it == lst.end());
+    ASSERT_TRUE(lst.empty());
+    ASSERT_TRUE(lst.begin() == lst.end());
+    lst.push_front(7);
+    ASSERT_EQUAL(lst.front(), 7);
+    ASSERT_EQUAL(lst.back(), 7);
+}
+
 TEST_MAIN()
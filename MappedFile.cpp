@@ -0,0 +1,73 @@
+#include "MappedFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+[[noreturn]] void fail(const std::string &filename) {
+    throw std::runtime_error(filename + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+MappedFile::MappedFile(const std::string &filename)
+  : bytes(nullptr), length(0), mapped(false) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0){
+        fail(filename);
+    }
+    struct stat info;
+    if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0){
+        void *start = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE,
+                           fd, 0);
+        if(start != MAP_FAILED){
+            // the contents are usually read front to back
+            madvise(start, info.st_size, MADV_SEQUENTIAL);
+            bytes = static_cast<const char *>(start);
+            length = info.st_size;
+            mapped = true;
+            close(fd);
+            return;
+        }
+    }
+
+    // not mappable, so read it all
+    char block[1 << 16];
+    ssize_t count;
+    while((count = read(fd, block, sizeof(block))) != 0){
+        if(count < 0){
+            if(errno == EINTR) continue;
+            int error = errno;
+            close(fd);
+            errno = error;
+            fail(filename);
+        }
+        copy.append(block, count);
+    }
+    close(fd);
+    bytes = copy.data();
+    length = copy.size();
+}
+
+MappedFile::~MappedFile() {
+    if(mapped){
+        munmap(const_cast<char *>(bytes), length);
+    }
+}
+
+std::string_view MappedFile::view() const {
+    return std::string_view(bytes, length);
+}
+
+std::size_t MappedFile::size() const {
+    return length;
+}
+
+bool MappedFile::is_mapped() const {
+    return mapped;
+}
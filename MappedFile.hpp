@@ -0,0 +1,47 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+/* MappedFile.hpp
+ *
+ * Read-only view of a whole file's contents. A regular file is mapped
+ * into memory, so opening it costs the same whatever its size and its
+ * pages are read in by the kernel as they are first touched. Anything
+ * that cannot be mapped, such as an empty file or a pipe, is read into
+ * memory instead.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile {
+public:
+  //EFFECTS: Opens the named file and maps its contents. Throws
+  //         std::runtime_error if the file cannot be opened or read.
+  explicit MappedFile(const std::string &filename);
+
+  ~MappedFile();
+
+  // disable copying
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  //EFFECTS: Returns the contents of the file. The view is valid for the
+  //         lifetime of this MappedFile.
+  std::string_view view() const;
+
+  //EFFECTS: Returns the size of the file in bytes.
+  std::size_t size() const;
+
+  //EFFECTS: Returns whether the contents are mapped rather than read.
+  bool is_mapped() const;
+
+private:
+  const char *bytes;   // start of the contents
+  std::size_t length;  // number of bytes in the contents
+  bool mapped;         // whether bytes is a mapping to unmap
+  std::string copy;    // the contents, if they were read instead
+};
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,53 @@
+#include "MappedFile.hpp"
+#include "unit_test_framework.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Helper: write contents to a fresh temporary file and return its name
+static string temp_file(const string &contents) {
+    static int count = 0;
+    string name = "MappedFile_tests_" + to_string(count++) + ".tmp";
+    ofstream(name, ios::binary) << contents;
+    return name;
+}
+
+TEST(test_maps_contents) {
+    string contents = "line one\r\nline two\n";
+    for (int i = 0; i < 15; ++i) contents += contents;
+    string name = temp_file(contents);
+    {
+        MappedFile file(name);
+        ASSERT_TRUE(file.is_mapped());
+        ASSERT_EQUAL(file.size(), contents.size());
+        ASSERT_TRUE(file.view() == contents);
+    }
+    remove(name.c_str());
+}
+
+TEST(test_empty_file) {
+    string name = temp_file("");
+    {
+        MappedFile file(name);
+        ASSERT_FALSE(file.is_mapped());
+        ASSERT_EQUAL(file.size(), 0u);
+        ASSERT_TRUE(file.view().empty());
+    }
+    remove(name.c_str());
+}
+
+TEST(test_missing_file_throws) {
+    bool threw = false;
+    try {
+        MappedFile file("MappedFile_tests_missing.tmp");
+    } catch (const runtime_error &) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST_MAIN()
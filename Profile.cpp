@@ -0,0 +1,92 @@
+#include "Profile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+
+Profile::Timer::Timer(Profile *profile_in, int stage_in)
+  : profile(profile_in), stage(stage_in) {
+    if(profile){
+        start = clock::now();
+    }
+}
+
+Profile::Timer::~Timer() {
+    if(profile){
+        profile->record(stage, start, clock::now());
+    }
+}
+
+Profile::Profile(const std::vector<std::string> &stage_names)
+  : names(stage_names), histograms(stage_names.size()),
+    created(clock::now()), trace(nullptr), first_event(true) {}
+
+Profile::~Profile() {
+    if(trace){
+        pending += "\n]\n";
+        flush();
+        std::fclose(trace);
+    }
+}
+
+void Profile::trace_to(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if(!file){
+        throw std::runtime_error("Unable to write " + path + ": "
+                                 + std::strerror(errno));
+    }
+    if(trace){
+        std::fclose(trace);
+    }
+    trace = file;
+    pending = "[";
+    first_event = true;
+}
+
+void Profile::record(int stage, clock::time_point start,
+                     clock::time_point end) {
+    histograms[stage].add(std::chrono::duration<double>(end - start)
+                          .count());
+    if(!trace) return;
+    // timestamps are in microseconds, the unit of the format
+    char event[256];
+    std::snprintf(event, sizeof(event),
+                  "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                  "\"ts\":%.3f,\"dur\":%.3f}",
+                  first_event ? "" : ",", names[stage].c_str(),
+                  std::chrono::duration<double, std::micro>(start - created)
+                  .count(),
+                  std::chrono::duration<double, std::micro>(end - start)
+                  .count());
+    first_event = false;
+    pending += event;
+    if(pending.size() >= TRACE_BLOCK){
+        flush();
+    }
+}
+
+const Histogram & Profile::histogram(int stage) const {
+    return histograms[stage];
+}
+
+void Profile::print(std::ostream &os) const {
+    os << std::left << std::setw(12) << "stage" << std::right
+       << std::setw(10) << "count" << std::setw(12) << "total"
+       << std::setw(12) << "p50" << std::setw(12) << "p99"
+       << std::setw(12) << "max" << "\n";
+    for(std::size_t stage = 0; stage < names.size(); ++stage){
+        const Histogram &times = histograms[stage];
+        if(times.count() == 0) continue;
+        os << std::left << std::setw(12) << names[stage] << std::right
+           << std::setw(10) << times.count()
+           << std::setw(12) << Histogram::format(times.total())
+           << std::setw(12) << Histogram::format(times.percentile(0.5))
+           << std::setw(12) << Histogram::format(times.percentile(0.99))
+           << std::setw(12) << Histogram::format(times.max()) << "\n";
+    }
+}
+
+void Profile::flush() {
+    std::fwrite(pending.data(), 1, pending.size(), trace);
+    pending.clear();
+}
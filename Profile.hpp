@@ -0,0 +1,89 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+/* Profile.hpp
+ *
+ * Timings of the stages of work a program repeats, such as handling a
+ * key or rendering a frame. Each stage keeps a Histogram of how long it
+ * took. Optionally, every timing is also written to a trace file in the
+ * Chrome trace event format, which chrome://tracing and Perfetto
+ * display as a timeline; stages timed within one another nest there.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Histogram.hpp"
+
+class Profile {
+public:
+  using clock = std::chrono::steady_clock;
+
+  // Times a stage from its construction to its destruction. Does
+  // nothing if the profile is null, so that code can be timed at the
+  // cost of a check when profiling is off.
+  class Timer {
+  public:
+    Timer(Profile *profile_in, int stage_in);
+    ~Timer();
+
+    Timer(const Timer &) = delete;
+    Timer & operator=(const Timer &) = delete;
+
+  private:
+    Profile *profile;
+    int stage;
+    clock::time_point start;
+  };
+
+  //REQUIRES: no name contains a quote, backslash or control character
+  //EFFECTS:  Creates a profile of stages with the given names, which are
+  //          numbered from 0 in order. Does not write a trace.
+  explicit Profile(const std::vector<std::string> &stage_names);
+
+  //EFFECTS:  Finishes and closes the trace file, if any.
+  ~Profile();
+
+  // disable copying
+  Profile(const Profile &) = delete;
+  Profile & operator=(const Profile &) = delete;
+
+  //MODIFIES: *this
+  //EFFECTS:  Writes all later timings to the named trace file, replacing
+  //          its contents. Throws std::runtime_error if it cannot be
+  //          created.
+  void trace_to(const std::string &path);
+
+  //REQUIRES: 0 <= stage < number of stages, start <= end
+  //MODIFIES: *this
+  //EFFECTS:  Records that the stage ran from start to end.
+  void record(int stage, clock::time_point start, clock::time_point end);
+
+  //REQUIRES: 0 <= stage < number of stages
+  //EFFECTS:  Returns the durations recorded for the stage.
+  const Histogram & histogram(int stage) const;
+
+  //MODIFIES: os
+  //EFFECTS:  Writes a table with a row for each stage that ran, giving
+  //          its count, total, median, 99th percentile and maximum.
+  void print(std::ostream &os) const;
+
+private:
+  static const std::size_t TRACE_BLOCK = 1 << 16; // bytes written at once
+
+  std::vector<std::string> names;
+  std::vector<Histogram> histograms;
+  clock::time_point created; // time 0 in the trace
+  std::FILE *trace;          // the trace file, if any
+  std::string pending;       // trace text not yet written
+  bool first_event;          // whether no event has been traced yet
+
+  //MODIFIES: *this
+  //EFFECTS:  Writes the pending trace text to the trace file.
+  void flush();
+};
+
+#endif // PROFILE_HPP
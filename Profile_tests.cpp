@@ -0,0 +1,93 @@
+#include "Profile.hpp"
+#include "unit_test_framework.hpp"
+#include "TestFiles.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static const string TRACE = TestFiles::scratch("Profile");
+
+// Helper: the number of times part occurs in text
+static int occurrences(const string &text, const string &part) {
+    int count = 0;
+    for (size_t at = text.find(part); at != string::npos;
+         at = text.find(part, at + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+TEST(test_records_stages) {
+    Profile profile({"first", "second"});
+    Profile::clock::time_point start = Profile::clock::now();
+    profile.record(0, start, start + chrono::microseconds(5));
+    profile.record(0, start, start + chrono::microseconds(7));
+    profile.record(1, start, start + chrono::milliseconds(2));
+    ASSERT_EQUAL(profile.histogram(0).count(), 2);
+    ASSERT_ALMOST_EQUAL(profile.histogram(0).total(), 12e-6, 1e-12);
+    ASSERT_EQUAL(profile.histogram(1).count(), 1);
+    ASSERT_ALMOST_EQUAL(profile.histogram(1).max(), 2e-3, 1e-12);
+}
+
+TEST(test_timer) {
+    Profile profile({"stage"});
+    {
+        Profile::Timer timer(&profile, 0);
+    }
+    ASSERT_EQUAL(profile.histogram(0).count(), 1);
+    ASSERT_TRUE(profile.histogram(0).max() < 1);
+    {
+        Profile::Timer timer(nullptr, 0); // profiling off
+    }
+    ASSERT_EQUAL(profile.histogram(0).count(), 1);
+}
+
+TEST(test_print) {
+    Profile profile({"ran", "idle"});
+    Profile::clock::time_point start = Profile::clock::now();
+    profile.record(0, start, start + chrono::microseconds(10));
+    ostringstream output;
+    profile.print(output);
+    string table = output.str();
+    ASSERT_EQUAL(table.substr(0, 5), "stage");
+    ASSERT_TRUE(table.find("ran") != string::npos);
+    // stages that never ran are left out
+    ASSERT_TRUE(table.find("idle") == string::npos);
+    ASSERT_EQUAL(occurrences(table, "\n"), 2);
+}
+
+TEST(test_trace) {
+    {
+        Profile profile({"outer", "inner"});
+        profile.trace_to(TRACE);
+        Profile::Timer outer(&profile, 0);
+        for (int i = 0; i < 3000; ++i) { // spans several blocks
+            Profile::Timer inner(&profile, 1);
+        }
+    }
+    string trace = TestFiles::contents(TRACE);
+    ASSERT_EQUAL(trace.substr(0, 2), "[\n");
+    ASSERT_EQUAL(trace.substr(trace.size() - 3), "\n]\n");
+    ASSERT_EQUAL(occurrences(trace, "\"name\":\"outer\""), 1);
+    ASSERT_EQUAL(occurrences(trace, "\"name\":\"inner\""), 3000);
+    ASSERT_EQUAL(occurrences(trace, "\"ph\":\"X\""), 3001);
+    ASSERT_EQUAL(occurrences(trace, "},\n{"), 3000);
+    remove(TRACE.c_str());
+}
+
+TEST(test_trace_to_missing_directory_throws) {
+    Profile profile({"stage"});
+    bool threw = false;
+    try {
+        profile.trace_to("Profile_tests_missing/trace.json");
+    } catch (const runtime_error &) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST_MAIN()
@@ -0,0 +1,300 @@
+#include "Regex.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+Regex::Regex(std::string_view pattern_in)
+  : nfa_start(-1), start_ids{-1, -1}, pattern(pattern_in), pos(0) {
+    Fragment whole = parse_alternation();
+    if(pos < pattern.size()){
+        // parse_alternation() only stops early at a ')'
+        fail("unmatched )");
+    }
+    nfa[whole.end].out = add_state(NfaState::MATCH);
+    nfa_start = whole.start;
+    pattern = std::string_view();
+}
+
+int Regex::num_dfa_states() const {
+    return dfa.size();
+}
+
+Regex::Fragment Regex::parse_alternation() {
+    Fragment left = parse_concatenation();
+    while(pos < pattern.size() && pattern[pos] == '|'){
+        pos++;
+        Fragment right = parse_concatenation();
+        int end = add_state(NfaState::SPLIT);
+        nfa[left.end].out = end;
+        nfa[right.end].out = end;
+        left = {add_state(NfaState::SPLIT, left.start, right.start), end};
+    }
+    return left;
+}
+
+Regex::Fragment Regex::parse_concatenation() {
+    Fragment whole = single(NfaState::SPLIT);
+    while(pos < pattern.size() && pattern[pos] != '|' && pattern[pos] != ')'){
+        Fragment next = parse_repetition();
+        nfa[whole.end].out = next.start;
+        whole.end = next.end;
+    }
+    return whole;
+}
+
+Regex::Fragment Regex::parse_repetition() {
+    Fragment atom = parse_atom();
+    while(pos < pattern.size()){
+        char op = pattern[pos];
+        if(op != '*' && op != '+' && op != '?') break;
+        pos++;
+        int end = add_state(NfaState::SPLIT);
+        int split = add_state(NfaState::SPLIT, atom.start, end);
+        if(op == '?'){
+            nfa[atom.end].out = end;
+            atom = {split, end};
+        }
+        else{
+            // loop back to the split after each repetition
+            nfa[atom.end].out = split;
+            atom = {op == '*' ? split : atom.start, end};
+        }
+    }
+    return atom;
+}
+
+Regex::Fragment Regex::parse_atom() {
+    char c = pattern[pos++];
+    if(c == '*' || c == '+' || c == '?'){
+        pos--;
+        fail("nothing to repeat");
+    }
+    if(c == '('){
+        Fragment group = parse_alternation();
+        if(pos >= pattern.size() || pattern[pos] != ')'){
+            fail("missing )");
+        }
+        pos++;
+        return group;
+    }
+    if(c == '['){
+        return parse_bracket();
+    }
+    if(c == '^'){
+        return single(NfaState::LINE_START);
+    }
+    if(c == '$'){
+        return single(NfaState::LINE_END);
+    }
+
+    std::bitset<256> chars;
+    if(c == '.'){
+        chars.set();
+        chars.reset('\n');
+    }
+    else if(c == '\\'){
+        chars = parse_escape();
+    }
+    else{
+        chars.set(static_cast<unsigned char>(c));
+    }
+    Fragment atom = single(NfaState::CHARS);
+    nfa[atom.start].chars = chars;
+    return atom;
+}
+
+Regex::Fragment Regex::parse_bracket() {
+    std::bitset<256> chars;
+    bool negate = pos < pattern.size() && pattern[pos] == '^';
+    if(negate){
+        pos++;
+    }
+    bool first = true;
+    while(true){
+        if(pos >= pattern.size()){
+            fail("missing ]");
+        }
+        char c = pattern[pos++];
+        if(c == ']' && !first){
+            break;
+        }
+        first = false;
+        if(c == '\\'){
+            chars |= parse_escape();
+            continue;
+        }
+        unsigned char low = c;
+        unsigned char high = c;
+        if(pos + 1 < pattern.size() && pattern[pos] == '-'
+           && pattern[pos + 1] != ']'){
+            high = pattern[pos + 1];
+            pos += 2;
+            if(high < low){
+                fail("invalid range");
+            }
+        }
+        for(int i = low; i <= high; i++){
+            chars.set(i);
+        }
+    }
+    if(negate){
+        chars.flip();
+        chars.reset('\n');
+    }
+    Fragment atom = single(NfaState::CHARS);
+    nfa[atom.start].chars = chars;
+    return atom;
+}
+
+std::bitset<256> Regex::parse_escape() {
+    if(pos >= pattern.size()){
+        fail("trailing \\");
+    }
+    char c = pattern[pos++];
+    std::bitset<256> chars;
+    switch(c){
+    case 'd':
+    case 'D':
+        for(int i = '0'; i <= '9'; i++) chars.set(i);
+        break;
+    case 'w':
+    case 'W':
+        for(int i = '0'; i <= '9'; i++) chars.set(i);
+        for(int i = 'a'; i <= 'z'; i++) chars.set(i);
+        for(int i = 'A'; i <= 'Z'; i++) chars.set(i);
+        chars.set('_');
+        break;
+    case 's':
+    case 'S':
+        for(char space : std::string_view(" \t\n\r\f\v")) chars.set(space);
+        break;
+    case 'n':
+        chars.set('\n');
+        return chars;
+    case 't':
+        chars.set('\t');
+        return chars;
+    default:
+        chars.set(static_cast<unsigned char>(c));
+        return chars;
+    }
+    if(c == 'D' || c == 'W' || c == 'S'){
+        // like '.', negated classes do not match a newline
+        chars.flip();
+        chars.reset('\n');
+    }
+    return chars;
+}
+
+int Regex::add_state(NfaState::Kind kind, int out, int out1) {
+    nfa.push_back({kind, std::bitset<256>(), out, out1});
+    return nfa.size() - 1;
+}
+
+Regex::Fragment Regex::single(NfaState::Kind kind) {
+    int state = add_state(kind);
+    return {state, state};
+}
+
+void Regex::fail(const char *message) const {
+    throw std::invalid_argument("invalid regex: " + std::string(message)
+                                + " at position " + std::to_string(pos));
+}
+
+std::vector<int> Regex::closure(const std::vector<int> &states,
+                                bool line_start, bool line_end) const {
+    std::vector<bool> visited(nfa.size());
+    std::vector<int> stack(states.begin(), states.end());
+    std::vector<int> result;
+    while(!stack.empty()){
+        int state = stack.back();
+        stack.pop_back();
+        if(state < 0 || visited[state]) continue;
+        visited[state] = true;
+        const NfaState &s = nfa[state];
+        switch(s.kind){
+        case NfaState::SPLIT:
+            stack.push_back(s.out1);
+            stack.push_back(s.out);
+            break;
+        case NfaState::LINE_START:
+            if(line_start){
+                stack.push_back(s.out);
+            }
+            break;
+        case NfaState::LINE_END:
+            if(line_end){
+                stack.push_back(s.out);
+            }
+            else{
+                // may still be followed if the next character is '\n'
+                result.push_back(state);
+            }
+            break;
+        case NfaState::CHARS:
+        case NfaState::MATCH:
+            result.push_back(state);
+            break;
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+int Regex::dfa_state(std::vector<int> states, bool line_start) {
+    auto key = std::make_pair(std::move(states), line_start);
+    auto found = dfa_ids.find(key);
+    if(found != dfa_ids.end()){
+        return found->second;
+    }
+    if(static_cast<int>(dfa.size()) >= MAX_DFA_STATES){
+        // flush rather than grow without bound
+        dfa.clear();
+        dfa_ids.clear();
+        start_ids[0] = start_ids[1] = -1;
+    }
+
+    DfaState state;
+    state.nfa_states = key.first;
+    state.line_start = line_start;
+    auto is_match = [this](int s) {
+        return nfa[s].kind == NfaState::MATCH;
+    };
+    state.accepts = std::any_of(key.first.begin(), key.first.end(), is_match);
+    std::vector<int> at_line_end = closure(key.first, line_start, true);
+    state.accepts_at_line_end =
+      std::any_of(at_line_end.begin(), at_line_end.end(), is_match);
+    std::fill(state.next, state.next + 256, -1);
+
+    dfa.push_back(std::move(state));
+    dfa_ids.emplace(std::move(key), dfa.size() - 1);
+    return dfa.size() - 1;
+}
+
+int Regex::start_state(bool line_start) {
+    if(start_ids[line_start] < 0){
+        int start = dfa_state(closure({nfa_start}, line_start, false),
+                              line_start);
+        start_ids[line_start] = start;
+    }
+    return start_ids[line_start];
+}
+
+int Regex::build_next(int state, unsigned char c) {
+    bool newline = (c == '\n');
+    std::vector<int> current =
+      closure(dfa[state].nfa_states, dfa[state].line_start, newline);
+    std::vector<int> moved;
+    for(int s : current){
+        if(nfa[s].kind == NfaState::CHARS && nfa[s].chars[c]){
+            moved.push_back(nfa[s].out);
+        }
+    }
+    std::size_t old_size = dfa.size();
+    int next = dfa_state(closure(moved, newline, false), newline);
+    if(dfa.size() >= old_size){
+        // the cache was not flushed, so state is still valid
+        dfa[state].next[c] = next;
+    }
+    return next;
+}
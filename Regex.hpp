@@ -0,0 +1,198 @@
+#ifndef REGEX_HPP
+#define REGEX_HPP
+/* Regex.hpp
+ *
+ * Regular expression matcher for searching text through iterators, so
+ * that a TextBuffer can be searched in place. A pattern is compiled to
+ * a Thompson NFA, which is converted to a DFA lazily: each DFA state and
+ * transition is built the first time a search needs it and cached for
+ * later searches with the same Regex.
+ *
+ * Supported syntax: literal characters, '.' (any character but '\n'),
+ * bracket expressions such as [a-z] and [^0-9], the escapes \d \w \s and
+ * their negations \D \W \S, '\' before any other character to match it
+ * literally, '^' and '$' (start and end of a line), grouping with ( ),
+ * alternation with |, and the quantifiers * + ?. Matches are
+ * leftmost-longest.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <bitset>
+#include <map>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class Regex {
+public:
+  //EFFECTS: Compiles the given pattern. Throws std::invalid_argument if
+  //         the pattern is malformed.
+  explicit Regex(std::string_view pattern);
+
+  //REQUIRES: [first, last) is a valid range of characters, and
+  //          line_start is whether first is at the start of a line
+  //MODIFIES: *this (the DFA cache)
+  //EFFECTS:  Searches [first, last) for the leftmost-longest match and
+  //          returns whether there is one. If so, sets match_begin and
+  //          match_end to the offsets from first of the start and end of
+  //          the match. '$' matches before '\n' and at last.
+  template <typename Iter>
+  bool search(Iter first, Iter last, bool line_start,
+              int &match_begin, int &match_end);
+
+  //REQUIRES: [first, last) is a valid range of characters, and
+  //          line_start is whether first is at the start of a line
+  //MODIFIES: *this (the DFA cache)
+  //EFFECTS:  Returns the length of the longest match that starts at
+  //          first, or -1 if no match starts there.
+  template <typename Iter>
+  int match_at(Iter first, Iter last, bool line_start);
+
+  //EFFECTS: Returns the number of DFA states currently cached.
+  int num_dfa_states() const;
+
+  // Maximum number of cached DFA states; the cache is flushed when a
+  // search would exceed it.
+  static const int MAX_DFA_STATES = 2048;
+
+private:
+  // A state of the NFA. CHARS states consume one character in chars;
+  // the others are followed without consuming anything. A SPLIT state
+  // with out1 == -1 just passes on to out.
+  struct NfaState {
+    enum Kind { CHARS, SPLIT, LINE_START, LINE_END, MATCH };
+    Kind kind;
+    std::bitset<256> chars; // characters a CHARS state accepts
+    int out;                // next state, or -1
+    int out1;               // second next state of a SPLIT, or -1
+  };
+
+  // A part of the NFA with one entry state and one exit state, whose
+  // out is patched to connect the next part.
+  struct Fragment {
+    int start;
+    int end;
+  };
+
+  // A state of the DFA: a set of NFA states, and whether the position
+  // it stands for is at the start of a line.
+  struct DfaState {
+    std::vector<int> nfa_states; // sorted
+    bool line_start;
+    bool accepts;                // matches here if not at a line end
+    bool accepts_at_line_end;    // matches here if at a line end
+    int next[256];               // transitions, or -1 if not yet built
+  };
+
+  std::vector<NfaState> nfa;
+  int nfa_start;
+
+  std::vector<DfaState> dfa;
+  std::map<std::pair<std::vector<int>, bool>, int> dfa_ids;
+  int start_ids[2]; // DFA start state for each line_start, or -1
+
+  // Parser state, used only while compiling.
+  std::string_view pattern;
+  std::size_t pos;
+
+  //MODIFIES: *this
+  //EFFECTS:  Parses part of the pattern into an NFA fragment.
+  Fragment parse_alternation();
+  Fragment parse_concatenation();
+  Fragment parse_repetition();
+  Fragment parse_atom();
+  Fragment parse_bracket();
+
+  //MODIFIES: *this
+  //EFFECTS:  Returns the set of characters that the escape sequence
+  //          starting after a '\' matches, consuming it.
+  std::bitset<256> parse_escape();
+
+  //MODIFIES: *this
+  //EFFECTS:  Adds an NFA state and returns its index.
+  int add_state(NfaState::Kind kind, int out = -1, int out1 = -1);
+
+  //MODIFIES: *this
+  //EFFECTS:  Returns a fragment made of a single state.
+  Fragment single(NfaState::Kind kind);
+
+  //EFFECTS:  Throws std::invalid_argument describing the error at the
+  //          current position in the pattern.
+  [[noreturn]] void fail(const char *message) const;
+
+  //EFFECTS:  Returns the NFA states reachable from states without
+  //          consuming a character, following LINE_START and LINE_END
+  //          states only if line_start or line_end.
+  std::vector<int> closure(const std::vector<int> &states,
+                           bool line_start, bool line_end) const;
+
+  //MODIFIES: *this
+  //EFFECTS:  Returns the DFA state for the given closed set of NFA
+  //          states, adding it to the cache if necessary.
+  int dfa_state(std::vector<int> states, bool line_start);
+
+  //MODIFIES: *this
+  //EFFECTS:  Returns the DFA start state.
+  int start_state(bool line_start);
+
+  //MODIFIES: *this
+  //EFFECTS:  Builds and caches the transition from state on c.
+  int build_next(int state, unsigned char c);
+
+  //MODIFIES: *this
+  //EFFECTS:  Returns the transition from state on c.
+  int step(int state, unsigned char c) {
+    int next = dfa[state].next[c];
+    return next >= 0 ? next : build_next(state, c);
+  }
+
+  //EFFECTS:  Returns whether state can no longer reach a match.
+  bool is_dead(int state) const {
+    return dfa[state].nfa_states.empty();
+  }
+
+  //EFFECTS:  Returns whether state is a match, given whether the
+  //          position is at the end of a line.
+  bool accepts(int state, bool line_end) const {
+    return line_end ? dfa[state].accepts_at_line_end : dfa[state].accepts;
+  }
+};
+
+template <typename Iter>
+bool Regex::search(Iter first, Iter last, bool line_start,
+                   int &match_begin, int &match_end) {
+  for (int offset = 0; ; ++first, ++offset) {
+    int length = match_at(first, last, line_start);
+    if (length >= 0) {
+      match_begin = offset;
+      match_end = offset + length;
+      return true;
+    }
+    if (first == last) {
+      return false;
+    }
+    line_start = (*first == '\n');
+  }
+}
+
+template <typename Iter>
+int Regex::match_at(Iter first, Iter last, bool line_start) {
+  int state = start_state(line_start);
+  int longest = -1;
+  for (int length = 0; ; ++first, ++length) {
+    bool at_last = (first == last);
+    if (accepts(state, at_last || *first == '\n')) {
+      longest = length;
+    }
+    if (at_last) {
+      return longest;
+    }
+    state = step(state, static_cast<unsigned char>(*first));
+    if (is_dead(state)) {
+      return longest;
+    }
+  }
+}
+
+#endif // REGEX_HPP
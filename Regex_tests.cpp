@@ -0,0 +1,131 @@
+#include "Regex.hpp"
+#include "unit_test_framework.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Helper: the first match of pattern in text as "begin,end", or "none"
+static string first_match(const string &pattern, const string &text) {
+    Regex regex(pattern);
+    int begin, end;
+    if (!regex.search(text.begin(), text.end(), true, begin, end)) {
+        return "none";
+    }
+    return to_string(begin) + "," + to_string(end);
+}
+
+// Helper: whether pattern compiles
+static bool compiles(const string &pattern) {
+    try {
+        Regex regex(pattern);
+        return true;
+    } catch (const invalid_argument &) {
+        return false;
+    }
+}
+
+TEST(test_literals) {
+    ASSERT_EQUAL(first_match("abc", "xxabcxx"), "2,5");
+    ASSERT_EQUAL(first_match("abd", "xxabcxx"), "none");
+    ASSERT_EQUAL(first_match("", "abc"), "0,0");
+    ASSERT_EQUAL(first_match("a\\.b", "a-b a.b"), "4,7");
+}
+
+TEST(test_quantifiers_are_longest) {
+    ASSERT_EQUAL(first_match("ab*", "xabbbc"), "1,5");
+    ASSERT_EQUAL(first_match("ab+", "xac abc"), "4,6");
+    ASSERT_EQUAL(first_match("colou?r", "color colour"), "0,5");
+    ASSERT_EQUAL(first_match("(ab)*c", "ababc"), "0,5");
+    ASSERT_EQUAL(first_match("a*", "bbb"), "0,0");
+}
+
+TEST(test_alternation_is_leftmost_longest) {
+    ASSERT_EQUAL(first_match("cat|category", "a category"), "2,10");
+    ASSERT_EQUAL(first_match("x|dog|cat", "hotdog cat"), "3,6");
+    ASSERT_EQUAL(first_match("a(b|)c", "ac"), "0,2");
+}
+
+TEST(test_classes) {
+    ASSERT_EQUAL(first_match("[0-9]+", "id=4521;"), "3,7");
+    ASSERT_EQUAL(first_match("[^a-z]", "abc1"), "3,4");
+    ASSERT_EQUAL(first_match("[]x]", "a]"), "1,2");
+    ASSERT_EQUAL(first_match("[a-]+", "b-a-"), "1,4");
+    ASSERT_EQUAL(first_match("\\d\\d:\\d\\d", "at 12:34"), "3,8");
+    ASSERT_EQUAL(first_match("\\w+", "  hello_1 "), "2,9");
+    ASSERT_EQUAL(first_match("\\s", "ab\tc"), "2,3");
+    ASSERT_EQUAL(first_match("[\\d.]+", "v1.25"), "1,5");
+}
+
+TEST(test_dot_and_negations_stop_at_newline) {
+    ASSERT_EQUAL(first_match("a.*", "abc\ndef"), "0,3");
+    ASSERT_EQUAL(first_match("a[^x]*", "abc\ndef"), "0,3");
+    ASSERT_EQUAL(first_match("a\\D*", "abc\ndef"), "0,3");
+    ASSERT_EQUAL(first_match("c\\nd", "abc\ndef"), "2,5");
+}
+
+TEST(test_anchors) {
+    ASSERT_EQUAL(first_match("^b", "ab\nbc"), "3,4");
+    ASSERT_EQUAL(first_match("b$", "bc\nab\n"), "4,5");
+    ASSERT_EQUAL(first_match("c$", "abc"), "2,3");
+    ASSERT_EQUAL(first_match("^$", "a\n\nb"), "2,2");
+    ASSERT_EQUAL(first_match("a$\n^b", "a\nb"), "0,3");
+    ASSERT_EQUAL(first_match("x$", "x y"), "none");
+
+    // line_start tells whether the range starts a line
+    Regex regex("^a");
+    string text = "ab";
+    int begin, end;
+    ASSERT_FALSE(regex.search(text.begin(), text.end(), false, begin, end));
+    ASSERT_TRUE(regex.search(text.begin(), text.end(), true, begin, end));
+}
+
+TEST(test_match_at) {
+    Regex regex("ab*");
+    string text = "abbx";
+    ASSERT_EQUAL(regex.match_at(text.begin(), text.end(), true), 3);
+    ASSERT_EQUAL(regex.match_at(text.begin() + 1, text.end(), false), -1);
+}
+
+TEST(test_invalid_patterns) {
+    ASSERT_FALSE(compiles("(ab"));
+    ASSERT_FALSE(compiles("ab)"));
+    ASSERT_FALSE(compiles("*a"));
+    ASSERT_FALSE(compiles("a|+"));
+    ASSERT_FALSE(compiles("[abc"));
+    ASSERT_FALSE(compiles("[z-a]"));
+    ASSERT_FALSE(compiles("ab\\"));
+    ASSERT_TRUE(compiles("a**"));
+    ASSERT_TRUE(compiles("()"));
+}
+
+TEST(test_dfa_cache_is_reused) {
+    Regex regex("[a-c]+x");
+    string text = "aabbccaabbx";
+    int begin, end;
+    ASSERT_TRUE(regex.search(text.begin(), text.end(), true, begin, end));
+    int states = regex.num_dfa_states();
+    ASSERT_TRUE(regex.search(text.begin(), text.end(), true, begin, end));
+    ASSERT_EQUAL(regex.num_dfa_states(), states);
+}
+
+TEST(test_dfa_cache_is_bounded) {
+    // (a|b)*a(a|b)^k needs 2^k DFA states
+    string pattern = "(a|b)*a";
+    for (int i = 0; i < 12; ++i) pattern += "(a|b)";
+    Regex regex(pattern);
+    string text;
+    unsigned bits = 0x9e3779b9;
+    for (int i = 0; i < 20000; ++i) {
+        bits = bits * 1103515245 + 12345;
+        text.push_back((bits >> 16) & 1 ? 'a' : 'b');
+    }
+    text += "c";
+    int begin, end;
+    ASSERT_TRUE(regex.search(text.begin(), text.end(), true, begin, end));
+    ASSERT_TRUE(regex.num_dfa_states() <= Regex::MAX_DFA_STATES);
+    ASSERT_EQUAL(begin, 0);
+}
+
+TEST_MAIN()
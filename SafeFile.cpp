@@ -0,0 +1,133 @@
+#include "SafeFile.hpp"
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SafeFile::SafeFile(const std::string &target_in)
+  : target(target_in), fd(-1), has_mode(false), mode(0) {
+    start();
+}
+
+SafeFile::SafeFile(const std::string &target_in, mode_t mode_in)
+  : target(target_in), fd(-1), has_mode(true), mode(mode_in) {
+    start();
+}
+
+SafeFile::~SafeFile() {
+    if(fd >= 0){
+        close(fd);
+        unlink(temp.c_str());
+    }
+}
+
+void SafeFile::start() {
+    struct stat link_info;
+    if(lstat(target.c_str(), &link_info) == 0 && S_ISLNK(link_info.st_mode)){
+        char resolved[PATH_MAX];
+        if(realpath(target.c_str(), resolved)){
+            target = resolved;
+        }
+    }
+    // A replacement, or a file given a mode, starts out private and gets
+    // its permissions on commit. A new file gets the usual permissions,
+    // narrowed by the umask as the file is created, since reading the
+    // umask would mean changing it for every thread.
+    struct stat info;
+    bool replacing = stat(target.c_str(), &info) == 0;
+    fd = create_temp(has_mode || replacing ? 0600 : 0666);
+    if(fd < 0){
+        fail("create a temporary file for");
+    }
+    block.reserve(BLOCK_SIZE);
+}
+
+void SafeFile::write(std::string_view text) {
+    write(text.begin(), text.end());
+}
+
+void SafeFile::commit(bool sync) {
+    flush();
+    struct stat info;
+    if(has_mode){
+        if(fchmod(fd, mode) != 0){
+            fail("chmod");
+        }
+    }
+    else if(stat(target.c_str(), &info) == 0){
+        if(fchmod(fd, info.st_mode & 07777) != 0){
+            fail("chmod");
+        }
+        // only allowed for the superuser or within the user's groups
+        if(fchown(fd, info.st_uid, info.st_gid) != 0){
+            errno = 0;
+        }
+    }
+    if(sync && fsync(fd) != 0){
+        fail("sync");
+    }
+    if(close(fd) != 0){
+        fd = -1;
+        unlink(temp.c_str());
+        fail("finish writing");
+    }
+    fd = -1;
+    if(std::rename(temp.c_str(), target.c_str()) != 0){
+        int error = errno;
+        unlink(temp.c_str());
+        errno = error;
+        fail("replace");
+    }
+    if(sync){
+        // make the rename itself durable
+        std::string::size_type slash = target.rfind('/');
+        std::string directory =
+          slash == std::string::npos ? "." : target.substr(0, slash + 1);
+        int dir_fd = open(directory.c_str(), O_RDONLY);
+        if(dir_fd >= 0){
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+    }
+}
+
+int SafeFile::create_temp(mode_t mode) {
+    static std::atomic<unsigned> count(0);
+    // the temporary file must be on the same file system to be renamed
+    std::string prefix = target + "." + std::to_string(getpid()) + ".";
+    for(int attempt = 0; attempt < MAX_TEMP_ATTEMPTS; ++attempt){
+        temp = prefix + std::to_string(count++);
+        int temp_fd = open(temp.c_str(), O_RDWR | O_CREAT | O_EXCL, mode);
+        if(temp_fd >= 0 || errno != EEXIST){
+            return temp_fd;
+        }
+    }
+    return -1;
+}
+
+void SafeFile::flush() {
+    const char *data = block.data();
+    std::size_t remaining = block.size();
+    while(remaining > 0){
+        ssize_t count = ::write(fd, data, remaining);
+        if(count < 0){
+            if(errno == EINTR) continue;
+            fail("write");
+        }
+        data += count;
+        remaining -= count;
+    }
+    block.clear();
+}
+
+void SafeFile::fail(const char *action) const {
+    throw std::runtime_error(std::string("unable to ") + action + " "
+                             + target + ": " + std::strerror(errno));
+}
@@ -0,0 +1,109 @@
+#ifndef SAFEFILE_HPP
+#define SAFEFILE_HPP
+/* SafeFile.hpp
+ *
+ * Replaces a file's contents without ever leaving it half-written. The
+ * new contents are streamed through a fixed-size block into a temporary
+ * file in the same directory, which is then renamed over the target in
+ * one atomic step. Until then, the target keeps its old contents, and a
+ * crash leaves at most a stray temporary file behind.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+
+class SafeFile {
+public:
+  //EFFECTS: Creates a temporary file to hold the new contents of the
+  //         named file. If the target is a symbolic link, the file it
+  //         points to is replaced instead. Throws std::runtime_error if
+  //         the temporary file cannot be created.
+  explicit SafeFile(const std::string &target);
+
+  //EFFECTS: Like SafeFile(target), but the new contents are given the
+  //         permissions in mode rather than the target's, e.g. for a
+  //         copy of a private file.
+  SafeFile(const std::string &target, mode_t mode);
+
+  //EFFECTS: Removes the temporary file unless commit() succeeded, so the
+  //         target is left as it was.
+  ~SafeFile();
+
+  // disable copying
+  SafeFile(const SafeFile &) = delete;
+  SafeFile & operator=(const SafeFile &) = delete;
+
+  //REQUIRES: [first, last) is a valid range of characters, and commit()
+  //          has not been called
+  //MODIFIES: *this
+  //EFFECTS:  Appends the characters to the new contents. Throws
+  //          std::runtime_error if writing fails.
+  template <typename Iter>
+  void write(Iter first, Iter last);
+
+  //REQUIRES: commit() has not been called
+  //MODIFIES: *this
+  //EFFECTS:  Appends text to the new contents. Throws std::runtime_error
+  //          if writing fails.
+  void write(std::string_view text);
+
+  //REQUIRES: commit() has not been called
+  //MODIFIES: *this
+  //EFFECTS:  Finishes writing and renames the temporary file over the
+  //          target, giving it the permissions given to the constructor,
+  //          or else the target's permissions (and owner, if allowed),
+  //          or the usual permissions for a new file. If sync
+  //          is true, the data is flushed to the disk first, and the
+  //          directory after the rename. Throws std::runtime_error on
+  //          failure, leaving the target as it was.
+  void commit(bool sync);
+
+  // Number of bytes gathered before each write to the temporary file.
+  static const int BLOCK_SIZE = 1 << 20;
+
+  // Number of names tried for the temporary file before giving up.
+  static const int MAX_TEMP_ATTEMPTS = 100;
+
+private:
+  std::string target;      // file being replaced
+  std::string temp;        // temporary file holding the new contents
+  int fd;                  // open descriptor of temp, or -1
+  bool has_mode;           // whether to give the file mode on commit
+  mode_t mode;             // permissions given, if has_mode
+  std::vector<char> block; // contents not yet written, up to BLOCK_SIZE
+
+  //MODIFIES: *this
+  //EFFECTS:  Resolves the target and creates the temporary file, as the
+  //          constructors describe.
+  void start();
+
+  //MODIFIES: *this
+  //EFFECTS:  Creates a temporary file next to the target with a name
+  //          not yet taken, given the mode as open() gives it, and
+  //          returns its descriptor, or -1 with errno set.
+  int create_temp(mode_t mode);
+
+  //MODIFIES: *this
+  //EFFECTS:  Writes out and empties the block.
+  void flush();
+
+  //EFFECTS:  Throws std::runtime_error describing the failed action and
+  //          the current errno.
+  [[noreturn]] void fail(const char *action) const;
+};
+
+template <typename Iter>
+void SafeFile::write(Iter first, Iter last) {
+  for (; first != last; ++first) {
+    if (block.size() == BLOCK_SIZE) {
+      flush();
+    }
+    block.push_back(*first);
+  }
+}
+
+#endif // SAFEFILE_HPP
@@ -0,0 +1,100 @@
+#include "SafeFile.hpp"
+#include "unit_test_framework.hpp"
+#include "TestFiles.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static const string TARGET = TestFiles::scratch("SafeFile");
+
+// Helper: the number of files in the current directory whose names
+// start with the target's, counting the target itself
+static int target_files() {
+    int count = 0;
+    DIR *directory = opendir(".");
+    while (dirent *entry = readdir(directory)) {
+        if (string(entry->d_name).rfind(TARGET, 0) == 0) ++count;
+    }
+    closedir(directory);
+    return count;
+}
+
+TEST(test_writes_and_replaces) {
+    TestFiles::write(TARGET, "old");
+    chmod(TARGET.c_str(), 0640);
+    string text = "new contents\n";
+    for (int i = 0; i < 17; ++i) text += text; // spans several blocks
+    {
+        SafeFile file(TARGET);
+        file.write(text.begin(), text.begin() + 5);
+        file.write(string_view(text).substr(5));
+        // the target is untouched until the commit
+        ASSERT_EQUAL(TestFiles::contents(TARGET), "old");
+        file.commit(true);
+    }
+    ASSERT_TRUE(TestFiles::contents(TARGET) == text);
+    struct stat info;
+    ASSERT_EQUAL(stat(TARGET.c_str(), &info), 0);
+    ASSERT_EQUAL(info.st_mode & 07777, 0640u);
+    ASSERT_EQUAL(target_files(), 1);
+    remove(TARGET.c_str());
+}
+
+TEST(test_uncommitted_leaves_target) {
+    TestFiles::write(TARGET, "old");
+    {
+        SafeFile file(TARGET);
+        file.write("new");
+    }
+    ASSERT_EQUAL(TestFiles::contents(TARGET), "old");
+    ASSERT_EQUAL(target_files(), 1);
+    remove(TARGET.c_str());
+}
+
+TEST(test_new_file) {
+    remove(TARGET.c_str());
+    mode_t mask = umask(022);
+    {
+        SafeFile file(TARGET);
+        file.write("fresh");
+        file.commit(false);
+    }
+    ASSERT_EQUAL(TestFiles::contents(TARGET), "fresh");
+    // the umask applies, and is left as it was
+    struct stat info;
+    ASSERT_EQUAL(stat(TARGET.c_str(), &info), 0);
+    ASSERT_EQUAL(info.st_mode & 07777, 0644u);
+    ASSERT_EQUAL(umask(mask), 022u);
+    remove(TARGET.c_str());
+}
+
+TEST(test_given_mode) {
+    TestFiles::write(TARGET, "old");
+    chmod(TARGET.c_str(), 0644);
+    {
+        SafeFile file(TARGET, 0600);
+        file.write("private");
+        file.commit(false);
+    }
+    struct stat info;
+    ASSERT_EQUAL(stat(TARGET.c_str(), &info), 0);
+    ASSERT_EQUAL(info.st_mode & 07777, 0600u);
+    remove(TARGET.c_str());
+}
+
+TEST(test_missing_directory_throws) {
+    bool threw = false;
+    try {
+        SafeFile file("SafeFile_tests_missing/file.txt");
+    } catch (const runtime_error &) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST_MAIN()
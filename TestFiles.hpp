@@ -0,0 +1,45 @@
+#ifndef TESTFILES_HPP
+#define TESTFILES_HPP
+/* TestFiles.hpp
+ *
+ * Helpers for the unit tests of modules that read and write files. The
+ * tests work on scratch files in the current directory, named for the
+ * tests that use them so that test programs do not collide.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+
+namespace TestFiles {
+  //EFFECTS: Returns the name of the scratch file for the named module's
+  //         tests, e.g. "SafeFile_tests.tmp" for "SafeFile".
+  inline std::string scratch(const std::string &module) {
+    return module + "_tests.tmp";
+  }
+
+  //EFFECTS: Returns whether the named file exists.
+  inline bool exists(const std::string &name) {
+    struct stat info;
+    return stat(name.c_str(), &info) == 0;
+  }
+
+  //EFFECTS: Returns the contents of the named file, or an empty string
+  //         if it cannot be read.
+  inline std::string contents(const std::string &name) {
+    std::ifstream input(name, std::ios::binary);
+    std::ostringstream result;
+    result << input.rdbuf();
+    return result.str();
+  }
+
+  //EFFECTS: Creates or replaces the named file with the given contents.
+  inline void write(const std::string &name, const std::string &text) {
+    std::ofstream(name, std::ios::binary) << text;
+  }
+}
+
+#endif // TESTFILES_HPP
@@ -1,25 +1,35 @@
 #include "TextBuffer.hpp"
+#include "ByteScan.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
 
 TextBuffer::TextBuffer()
-  : data(), cursor(data.end()), row(1), column(0), index(0)
+  : data(std::make_shared<CharList>()), cursor(data->end()), row(1),
+    column(0), index(0), newlines(0),
+    journaling(true), batching(false), edit_group(0), utf8(false),
+    clean_length(0), clean_prefix(0), clean_suffix(0)
 {}
 
 
 bool TextBuffer::forward() {
     
-    if(cursor == data.end()){
+    if(cursor == data->end()){
         return false;
     }
     
+    int size = char_size();
     char oldChar = *cursor;
-    cursor++;
-    index++;
+    for(int i = 0; i < size; i++){
+        cursor++;
+    }
+    index += size;
 
     if(oldChar == '\n'){
         column = 0;
         row++;
     }
-    else{
+    else if(starts_column(oldChar)){
         column++;
     }
 
@@ -28,16 +38,23 @@ bool TextBuffer::forward() {
 }
 
 bool TextBuffer::backward() {
-    if(cursor == data.begin()){
+    if(cursor == data->begin()){
         return false;
     }
     cursor--;
     index--;
+    // back up to the first byte of a UTF-8 codepoint, which has at most
+    // three continuation bytes
+    for(int i = 0; i < 3 && !starts_column(*cursor)
+                   && cursor != data->begin(); i++){
+        cursor--;
+        index--;
+    }
     if(*cursor == '\n'){
         row--;
         column = compute_column();
     }
-    else{
+    else if(starts_column(*cursor)){
         column--;
     }
     return true;
@@ -46,25 +63,335 @@ bool TextBuffer::backward() {
 }
 
 void TextBuffer::insert(char c) {
-    data.insert(cursor, c);
+    detach();
+    record_insert(index, std::string_view(&c, 1));
+    shift_cursors(index, 1);
+    data->insert(cursor, c);
+    shift_marks(index, 1, c == '\n', cursor);
     index++;
     
     if(c == '\n'){
         row++;
         column = 0;
+        newlines++;
     }
-    else{
+    else if(starts_column(c)){
         column++;
     }
 
 
 }
 
+void TextBuffer::insert(std::string_view text) {
+    if(text.empty()) return;
+    detach();
+    record_insert(index, text);
+    shift_cursors(index, text.size());
+    for(char c : text){
+        data->insert(cursor, c);
+    }
+    const char *text_end = text.data() + text.size();
+    int added_rows = ByteScan::count(text.data(), text_end, '\n');
+    int last_newline = ByteScan::rfind(text.data(), text_end, '\n')
+                       - text.data();
+    shift_marks(index, text.size(), added_rows, cursor);
+    index += text.size();
+    row += added_rows;
+    newlines += added_rows;
+    if(added_rows > 0){
+        column = count_columns(text.substr(last_newline + 1));
+    }
+    else{
+        column += count_columns(text);
+    }
+}
+
+void TextBuffer::append(std::string_view text) {
+    detach();
+    int at = data->size();
+    int added_rows = ByteScan::count(text.data(), text.data() + text.size(),
+                                     '\n');
+    shift_cursors(at, text.size());
+    for(char c : text){
+        data->push_back(c);
+    }
+    // the text extends the clean contents rather than changing them
+    bool unchanged = clean_prefix == at && at == clean_length;
+    int suffix = clean_suffix;
+    shift_marks(at, text.size(), added_rows, data->end());
+    clean_length += text.size();
+    clean_suffix = suffix + text.size();
+    if(unchanged){
+        clean_prefix = clean_length;
+    }
+    newlines += added_rows;
+    if(cursor == data->end()){
+        index += text.size();
+        row += added_rows;
+        column = compute_column();
+    }
+}
+
 bool TextBuffer::remove() {
-    if(cursor == data.end()) return false;
-    cursor = data.erase(cursor);
+    if(cursor == data->end()) return false;
+    if(char_size() > 1){
+        return remove(char_size()) > 0;
+    }
+    detach();
+    record_remove(index, std::string(1, *cursor));
+    shift_cursors(index, -1);
+    int removed_rows = 0;
+    if(*cursor == '\n'){
+        newlines--;
+        removed_rows++;
+    }
+    cursor = data->erase(cursor);
+    shift_marks(index, -1, -removed_rows, cursor);
+    return true;
+
+}
+
+int TextBuffer::remove(int n, std::string *removed) {
+    detach();
+    Iterator last = cursor;
+    std::string text;
+    int removed_rows = 0;
+    for(; static_cast<int>(text.size()) < n && last != data->end(); last++){
+        if(*last == '\n'){
+            removed_rows++;
+        }
+        text.push_back(*last);
+    }
+    cursor = data->erase(cursor, last);
+    newlines -= removed_rows;
+    if(!text.empty()){
+        record_remove(index, text);
+        shift_cursors(index, -static_cast<int>(text.size()));
+        shift_marks(index, -static_cast<int>(text.size()), -removed_rows,
+                    cursor);
+    }
+    if(removed){
+        removed->append(text);
+    }
+    return text.size();
+}
+
+int TextBuffer::remove_range(int begin_index, int end_index,
+                             std::string *removed) {
+    seek_index(begin_index);
+    return remove(end_index - begin_index, removed);
+}
+
+bool TextBuffer::undo() {
+    if(undo_log.empty()) return false;
+    int group = undo_log.newest_group();
+    journaling = false;
+    while(undo_log.newest_group() == group){
+        UndoLog::Edit edit = undo_log.pop();
+        apply_edit(edit, true);
+        redo_log.push(std::move(edit));
+    }
+    journaling = true;
+    return true;
+}
+
+bool TextBuffer::redo() {
+    if(redo_log.empty()) return false;
+    int group = redo_log.newest_group();
+    journaling = false;
+    while(redo_log.newest_group() == group){
+        UndoLog::Edit edit = redo_log.pop();
+        apply_edit(edit, false);
+        undo_log.push(std::move(edit));
+    }
+    journaling = true;
     return true;
+}
+
+void TextBuffer::add_cursor(int at){
+    auto pos = std::lower_bound(cursors.begin(), cursors.end(), at);
+    if(pos == cursors.end() || *pos != at){
+        cursors.insert(pos, at);
+    }
+}
+
+void TextBuffer::clear_cursors(){
+    cursors.clear();
+}
+
+const std::vector<int> & TextBuffer::get_cursors() const{
+    return cursors;
+}
+
+void TextBuffer::insert_at_cursors(std::string_view text){
+    if(text.empty()) return;
+    detach();
+    std::vector<int> positions = cursor_positions();
+    int length = text.size();
+    int text_rows = ByteScan::count(text.data(), text.data() + text.size(),
+                                    '\n');
+
+    begin_batch();
+    ConstIterator it = iterator_at(positions.front());
+    int pos = positions.front();
+    int primary = 0;
+    for(std::size_t k = 0; k < positions.size(); k++){
+        for(; pos < positions[k]; pos++){
+            ++it;
+        }
+        for(char c : text){
+            data->insert(it, c);
+        }
+        // earlier insertions have shifted this position by k * length
+        record_insert(positions[k] + k * length, text);
+        shift_marks(positions[k] + k * length, length, text_rows, cursor);
+        if(positions[k] == index){
+            primary = k;
+        }
+    }
+    end_batch();
+
+    // every position moves past its own text and the text before it
+    cursors.clear();
+    for(std::size_t k = 0; k < positions.size(); k++){
+        if(static_cast<int>(k) != primary){
+            cursors.push_back(positions[k] + (k + 1) * length);
+        }
+    }
+    index += (primary + 1) * length;
+    row += (primary + 1) * text_rows;
+    newlines += positions.size() * text_rows;
+    column = compute_column();
+}
+
+int TextBuffer::remove_at_cursors(){
+    detach();
+    std::vector<int> positions = cursor_positions();
+    int size = data->size();
+
+    begin_batch();
+    ConstIterator it = iterator_at(positions.front());
+    int pos = positions.front();
+    int removed = 0;
+    int primary_index = index;
+    cursors.clear();
+    for(int at : positions){
+        for(; pos < at; pos++){
+            ++it;
+        }
+        int new_at = at - removed;
+        if(at == index){
+            primary_index = new_at;
+        }
+        else if(cursors.empty() || cursors.back() != new_at){
+            cursors.push_back(new_at);
+        }
+        if(at == size) continue;
+
+        int removed_rows = 0;
+        if(*it == '\n'){
+            newlines--;
+            removed_rows++;
+            if(at < index){
+                row--;
+            }
+        }
+        record_remove(new_at, std::string(1, *it));
+        // the primary cursor follows its character's successor, which
+        // may itself be removed by a later cursor
+        bool moves_cursor = (it == cursor);
+        Iterator next = data->erase(it);
+        if(moves_cursor){
+            cursor = next;
+        }
+        shift_marks(new_at, -1, -removed_rows, next);
+        it = next;
+        pos++;
+        removed++;
+    }
+    end_batch();
+
+    index = primary_index;
+    cursors.erase(std::remove(cursors.begin(), cursors.end(), index),
+                  cursors.end());
+    column = compute_column();
+    return removed;
+}
+
+int TextBuffer::set_mark(){
+    Mark mark = {cursor, index, row, true};
+    for(std::size_t i = 0; i < marks.size(); i++){
+        if(!marks[i].active){
+            marks[i] = mark;
+            return i;
+        }
+    }
+    marks.push_back(mark);
+    return marks.size() - 1;
+}
 
+void TextBuffer::goto_mark(int mark){
+    cursor = marks[mark].position;
+    index = marks[mark].index;
+    row = marks[mark].row;
+    column = compute_column();
+}
+
+int TextBuffer::get_mark_index(int mark) const{
+    return marks[mark].index;
+}
+
+void TextBuffer::clear_mark(int mark){
+    marks[mark].active = false;
+    while(!marks.empty() && !marks.back().active){
+        marks.pop_back();
+    }
+}
+
+void TextBuffer::set_undo_limit(std::size_t bytes, bool spill){
+    undo_log.set_limit(bytes, spill);
+    redo_log.set_limit(bytes, spill);
+}
+
+void TextBuffer::clear_undo(){
+    undo_log.clear();
+    redo_log.clear();
+}
+
+void TextBuffer::clear(){
+    data = std::make_shared<CharList>(); // a snapshot keeps the old list
+    cursor = data->end();
+    row = 1;
+    column = 0;
+    index = 0;
+    newlines = 0;
+    for(Mark &mark : marks){
+        mark = {cursor, 0, 1, mark.active};
+    }
+    cursors.clear();
+    clear_undo();
+    clean_length = clean_prefix = clean_suffix = 0;
+}
+
+void TextBuffer::set_utf8(bool on){
+    utf8 = on;
+    column = compute_column();
+}
+
+bool TextBuffer::is_utf8() const{
+    return utf8;
+}
+
+int TextBuffer::char_size() const{
+    if(cursor == data->end()) return 0;
+    if(!utf8) return 1;
+    // the lead byte and up to three continuation bytes after it
+    ConstIterator it = cursor;
+    int size = 1;
+    for(++it; size < 4 && it != data->end() && !starts_column(*it); ++it){
+        size++;
+    }
+    return size;
 }
 
 void TextBuffer::move_to_row_start() {
@@ -75,7 +402,7 @@ void TextBuffer::move_to_row_start() {
 }
 
 void TextBuffer::move_to_row_end() {
-    while(cursor != data.end() && *cursor != '\n'){
+    while(cursor != data->end() && *cursor != '\n'){
         forward();
     }
 
@@ -86,7 +413,7 @@ void TextBuffer::move_to_column(int new_column){
         new_column = 0;
     }
     if(new_column > column){
-        while(cursor != data.end() && column < new_column && *cursor != '\n'){
+        while(cursor != data->end() && column < new_column && *cursor != '\n'){
             forward();
         }
     }
@@ -105,7 +432,7 @@ bool TextBuffer::up() {
     }
     int moveCol = column;
     move_to_row_start();
-    if(cursor != data.begin()){
+    if(cursor != data->begin()){
         backward();
     }
     move_to_row_start();
@@ -117,7 +444,7 @@ bool TextBuffer::up() {
 bool TextBuffer::down(){
     int moveCol = column;
     move_to_row_end();
-    if(cursor == data.end() || *cursor != '\n'){
+    if(cursor == data->end() || *cursor != '\n'){
         return false;
     }
     
@@ -126,8 +453,387 @@ bool TextBuffer::down(){
     return true;
 }
 
+void TextBuffer::seek_index(int new_index){
+    int size = data->size();
+    bool column_known = true;
+    if(new_index <= index / 2){
+        cursor = data->begin();
+        index = 0;
+        row = 1;
+        column = 0;
+    }
+    else if(new_index >= index + (size - index) / 2){
+        cursor = data->end();
+        index = size;
+        row = newlines + 1;
+        column_known = false;
+    }
+
+    while(index < new_index){
+        forward();
+    }
+    // walk backward without recomputing the column at each newline
+    while(index > new_index){
+        cursor--;
+        index--;
+        if(*cursor == '\n'){
+            row--;
+            column_known = false;
+        }
+        else if(starts_column(*cursor)){
+            column--;
+        }
+    }
+    if(!column_known){
+        column = compute_column();
+    }
+}
+
+TextBuffer::ConstIterator TextBuffer::row_start(int target_row) const{
+    int last_row = newlines + 1;
+    ConstIterator it = cursor;
+    int at_row = row;
+    int from_cursor = std::abs(target_row - row);
+    if(target_row - 1 <= from_cursor
+       && target_row - 1 <= last_row - target_row){
+        it = data->begin();
+        at_row = 1;
+    }
+    else if(last_row - target_row < from_cursor){
+        it = data->end();
+        at_row = last_row;
+    }
+
+    for(; at_row < target_row; ++it){
+        if(*it == '\n'){
+            at_row++;
+        }
+    }
+    // walk backward to the start of target_row
+    while(it != data->begin()){
+        ConstIterator prev = it;
+        prev--;
+        if(*prev == '\n'){
+            if(at_row == target_row){
+                break;
+            }
+            at_row--;
+        }
+        it = prev;
+    }
+    return it;
+}
+
+bool TextBuffer::seek_row_col(int new_row, int new_column){
+    int last_row = newlines + 1;
+    bool exists = new_row >= 1 && new_row <= last_row;
+    new_row = std::max(1, std::min(new_row, last_row));
+
+    int from_cursor = std::abs(new_row - row);
+    if(new_row - 1 <= from_cursor && new_row - 1 <= last_row - new_row){
+        cursor = data->begin();
+        index = 0;
+        row = 1;
+    }
+    else if(last_row - new_row < from_cursor){
+        cursor = data->end();
+        index = data->size();
+        row = last_row;
+    }
+
+    while(row < new_row){
+        forward();
+    }
+    // walk backward to the start of new_row
+    while(cursor != data->begin()){
+        Iterator prev = cursor;
+        prev--;
+        if(*prev == '\n'){
+            if(row == new_row){
+                break;
+            }
+            row--;
+        }
+        cursor = prev;
+        index--;
+    }
+    column = 0;
+    move_to_column(new_column);
+    return exists;
+}
+
+void TextBuffer::seek_fraction(double fraction){
+    fraction = std::max(0.0, std::min(fraction, 1.0));
+    seek_index(static_cast<int>(fraction * data->size()));
+}
+
+int TextBuffer::find(std::string_view needle, int from_index,
+                     Direction direction) const{
+    int size = data->size();
+    int length = needle.size();
+    if(direction == FORWARD){
+        from_index = std::max(from_index, 0);
+    }
+    else{
+        from_index = std::min(from_index, size - length);
+    }
+    if(from_index < 0 || from_index + length > size){
+        return -1;
+    }
+    if(length == 0){
+        return from_index;
+    }
+
+    int shift[256];
+    horspool_shifts(needle, direction, shift);
+    if(direction == FORWARD){
+        int last_index = from_index + length - 1;
+        ConstIterator last = iterator_at(last_index);
+        return find_forward(needle, shift, last, last_index);
+    }
+    else{
+        int first_index = from_index;
+        ConstIterator first = iterator_at(first_index);
+        while(true){
+            ConstIterator it = first;
+            for(int i = 0; *it == needle[i]; i++, it++){
+                if(i == length - 1){
+                    return first_index;
+                }
+            }
+            int skip = shift[static_cast<unsigned char>(*first)];
+            if(first_index - skip < 0){
+                return -1;
+            }
+            first_index -= skip;
+            for(; skip > 0; skip--){
+                --first;
+            }
+        }
+    }
+}
+
+int TextBuffer::replace_all(std::string_view needle,
+                            std::string_view replacement){
+    int length = needle.size();
+    if(length == 0 || length > size()) return 0;
+    detach();
+
+    int shift[256];
+    horspool_shifts(needle, FORWARD, shift);
+    int delta = replacement.size() - length;
+    int needle_rows = ByteScan::count(needle.data(), needle.data() + length,
+                                      '\n');
+    int replacement_rows =
+      ByteScan::count(replacement.data(),
+                      replacement.data() + replacement.size(), '\n');
+    int row_delta = replacement_rows - needle_rows;
+
+    // the cursor and marks, in index order, fixed up as hits pass them
+    struct Position {
+        int *index;
+        int *row;
+        Iterator *it;
+    };
+    std::vector<Position> positions = {{&index, &row, &cursor}};
+    for(Mark &mark : marks){
+        if(mark.active){
+            positions.push_back({&mark.index, &mark.row, &mark.position});
+        }
+    }
+    std::sort(positions.begin(), positions.end(),
+              [](const Position &a, const Position &b) {
+                  return *a.index < *b.index;
+              });
+    std::size_t next_position = 0;
+
+    // indices of the hits before the rewrite
+    std::vector<int> starts;
+    // iterators left on the character after the last hit, which must
+    // move if that character starts the next hit
+    std::vector<Iterator *> pending;
+    int last_index = length - 1;
+    ConstIterator last = iterator_at(last_index);
+    while(true){
+        int found = find_forward(needle, shift, last, last_index);
+        if(found < 0) break;
+        int hits = starts.size();
+        int start = found - hits * delta;
+        starts.push_back(start);
+        for(; next_position < positions.size()
+              && *positions[next_position].index < start; next_position++){
+            *positions[next_position].index += hits * delta;
+            *positions[next_position].row += hits * row_delta;
+        }
+
+        // relink: unlink the hit, then insert the replacement before
+        // the character that followed it
+        ConstIterator first = last;
+        for(int i = 1; i < length; i++){
+            --first;
+        }
+        if(hits > 0 && start != starts[hits - 1] + length){
+            pending.clear();
+        }
+        Iterator next = data->erase(first, ++last);
+        Iterator inserted = next;
+        for(auto c = replacement.rbegin(); c != replacement.rend(); ++c){
+            inserted = data->insert(inserted, *c);
+        }
+        // positions after the last hit stay between the two replacements
+        for(Iterator *it : pending){
+            *it = inserted;
+        }
+        if(!replacement.empty()){
+            pending.clear();
+        }
+        int resume = found + replacement.size();
+
+        // positions on the hit move to just after the replacement
+        for(; next_position < positions.size()
+              && *positions[next_position].index < start + length;
+            next_position++){
+            const Position &p = positions[next_position];
+            int passed_rows = std::count(needle.begin(),
+                                         needle.begin() + (*p.index - start),
+                                         '\n');
+            *p.row += hits * row_delta + replacement_rows - passed_rows;
+            *p.index = resume;
+            *p.it = next;
+            pending.push_back(p.it);
+        }
+
+        if(resume + length > static_cast<int>(data->size())) break;
+        last_index = resume + length - 1;
+        last = next;
+        for(int i = 1; i < length; i++){
+            ++last;
+        }
+    }
+
+    int hits = starts.size();
+    for(; next_position < positions.size(); next_position++){
+        *positions[next_position].index += hits * delta;
+        *positions[next_position].row += hits * row_delta;
+    }
+    for(int &pos : cursors){
+        // hits that end at or before pos
+        int k = std::upper_bound(starts.begin(), starts.end(), pos - length)
+                - starts.begin();
+        if(k < hits && starts[k] <= pos){
+            pos = starts[k] + k * delta + replacement.size();
+        }
+        else{
+            pos += k * delta;
+        }
+    }
+    cursors.erase(std::unique(cursors.begin(), cursors.end()),
+                  cursors.end());
+    newlines += hits * row_delta;
+    column = compute_column();
+    if(hits > 0){
+        int old_size = data->size() - hits * delta;
+        clean_prefix = std::min(clean_prefix, starts.front());
+        clean_suffix = std::min(clean_suffix,
+                                old_size - starts.back() - length);
+    }
+
+    if(journaling && hits > 0){
+        record_replace_all(starts, needle, replacement);
+    }
+    return hits;
+}
+
+void TextBuffer::record_replace_all(const std::vector<int> &starts,
+                                    std::string_view needle,
+                                    std::string_view replacement){
+    // journal the rewritten span as one removal and one insertion,
+    // rebuilding its old text from the new text and the hits
+    int delta = replacement.size() - needle.size();
+    int hits = starts.size();
+    int span_begin = starts.front();
+    int span_end = starts.back() + (hits - 1) * delta + replacement.size();
+    std::string new_text = view(span_begin, span_end).str();
+    std::string old_text;
+    old_text.reserve(new_text.size() - hits * delta);
+    int from = 0;
+    for(int k = 0; k < hits; k++){
+        int at = starts[k] + k * delta - span_begin;
+        old_text.append(new_text, from, at - from);
+        old_text.append(needle);
+        from = at + replacement.size();
+    }
+    begin_batch();
+    record_remove(span_begin, old_text);
+    record_insert(span_begin, new_text);
+    end_batch();
+}
+
+int TextBuffer::find(Regex &pattern, int from_index, int *match_end) const{
+    int size = data->size();
+    from_index = std::max(from_index, 0);
+    if(from_index > size){
+        return -1;
+    }
+    ConstIterator first = iterator_at(from_index);
+    bool line_start = true;
+    if(from_index > 0){
+        ConstIterator previous = first;
+        --previous;
+        line_start = (*previous == '\n');
+    }
+    View rest(first, data->end(), size - from_index);
+    int begin, end;
+    if(!pattern.search(rest.begin(), rest.end(), line_start, begin, end)){
+        return -1;
+    }
+    if(match_end){
+        *match_end = from_index + end;
+    }
+    return from_index + begin;
+}
+
+std::vector<TextBuffer::Range> TextBuffer::find_all(Regex &pattern) const{
+    std::vector<Range> matches;
+    View text = view();
+    View::Iterator it = text.begin();
+    int at = 0;
+    bool line_start = true;
+    int begin, end;
+    while(pattern.search(it, text.end(), line_start, begin, end)){
+        matches.push_back({at + begin, at + end});
+        // continue after the match, or one past an empty match
+        int skip = (end > begin) ? end : end + 1;
+        if(at + skip > text.size()){
+            break;
+        }
+        for(int i = 0; i < skip; i++, ++it){
+            line_start = (*it == '\n');
+        }
+        at += skip;
+    }
+    return matches;
+}
+
+int TextBuffer::replace_ranges(const std::vector<Range> &ranges,
+                               std::string_view replacement){
+    if(ranges.empty()) return 0;
+    int home = set_mark();
+    begin_batch();
+    for(auto range = ranges.rbegin(); range != ranges.rend(); ++range){
+        remove_range(range->begin, range->end);
+        if(!replacement.empty()){
+            insert(replacement);
+        }
+    }
+    end_batch();
+    goto_mark(home);
+    clear_mark(home);
+    return ranges.size();
+}
+
 bool TextBuffer::is_at_end() const{
-    return cursor == data.end();
+    return cursor == data->end();
 }
 
 char TextBuffer::data_at_cursor() const{
@@ -146,33 +852,329 @@ int TextBuffer::get_index() const{
     return index;
 }
 int TextBuffer::size() const{
-    return data.size();
+    return data->size();
+}
+
+int TextBuffer::num_rows() const{
+    return newlines + 1;
 }
 
 std::string TextBuffer::stringify() const{
-    std::string s = "";
-    for(auto it = data.begin(); it != data.end(); it++){
-        s+=*it;
+    return view().str();
+}
+
+std::string TextBuffer::View::str() const{
+    std::string s;
+    s.reserve(length);
+    for(Iterator it = begin(); it != end(); ++it){
+        s.push_back(*it);
     }
     return s;
 }
-int TextBuffer::compute_column() const{
-    Iterator it = cursor;
-    int count = 0;
 
-    if(data.empty()) return 0;
+TextBuffer::View TextBuffer::view() const{
+    return View(data->begin(), data->end(), data->size());
+}
 
-    if(it == data.end()){
-        it--;
+TextBuffer::Snapshot TextBuffer::snapshot() const{
+    return Snapshot(data);
+}
+
+void TextBuffer::mark_clean(){
+    clean_length = clean_prefix = clean_suffix = data->size();
+}
+
+TextBuffer::Range TextBuffer::changed_range() const{
+    int end = static_cast<int>(data->size()) - clean_suffix;
+    return {clean_prefix, std::max(clean_prefix, end)};
+}
+
+std::vector<TextBuffer::View> TextBuffer::row_views(int first_row,
+                                                    int count) const{
+    std::vector<View> rows;
+    int last_row = newlines + 1;
+    if(first_row > last_row || count <= 0) return rows;
+    ConstIterator it = row_start(first_row);
+    for(int r = first_row; r <= last_row && r < first_row + count; r++){
+        ConstIterator start = it;
+        int length = 0;
+        for(; it != data->end() && *it != '\n'; ++it){
+            length++;
+        }
+        if(it != data->end()){
+            ++it; // include the newline
+            length++;
+        }
+        rows.push_back(View(start, it, length));
+    }
+    return rows;
+}
+
+int TextBuffer::clean_size() const{
+    return clean_length;
+}
+
+TextBuffer::View TextBuffer::Snapshot::view() const{
+    return View(data->begin(), data->end(), data->size());
+}
+
+int TextBuffer::Snapshot::size() const{
+    return data->size();
+}
+
+std::string TextBuffer::Snapshot::stringify() const{
+    return view().str();
+}
+
+TextBuffer::View TextBuffer::view(int begin_index, int end_index) const{
+    ConstIterator first = iterator_at(begin_index);
+    ConstIterator last = first;
+    for(int i = begin_index; i < end_index; i++){
+        last++;
     }
+    return View(first, last, end_index - begin_index);
+}
+int TextBuffer::compute_column() const{
+    ConstIterator it = cursor;
+    int count = 0;
+    // gather the row into blocks so that codepoints are counted with
+    // the vector kernels
+    char block[256];
+    int filled = 0;
 
-    while(it != data.begin()){
+    while(it != data->begin()){
         it--;
         if(*it == '\n'){
             break;
         }
-        count++;
+        block[filled++] = *it;
+        if(filled == sizeof(block)){
+            count += count_columns(std::string_view(block, filled));
+            filled = 0;
+        }
     }
-    return count;
+    return count + count_columns(std::string_view(block, filled));
 }
 
+bool TextBuffer::starts_column(char c) const{
+    return !utf8 || (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+}
+
+int TextBuffer::count_columns(std::string_view text) const{
+    if(!utf8) return text.size();
+    return ByteScan::count_codepoints(text.data(), text.data() + text.size());
+}
+
+TextBuffer::ConstIterator TextBuffer::iterator_at(int target_index) const{
+    int size = data->size();
+    ConstIterator it;
+    if(target_index <= index / 2){
+        it = data->begin();
+        for(int i = 0; i < target_index; i++){
+            it++;
+        }
+    }
+    else if(target_index >= index + (size - index) / 2){
+        it = data->end();
+        for(int i = size; i > target_index; i--){
+            it--;
+        }
+    }
+    else{
+        it = cursor;
+        for(int i = index; i < target_index; i++){
+            it++;
+        }
+        for(int i = index; i > target_index; i--){
+            it--;
+        }
+    }
+    return it;
+}
+
+void TextBuffer::record_insert(int at, std::string_view text){
+    if(!journaling) return;
+    redo_log.clear();
+    UndoLog::Edit *last = undo_log.newest();
+    if(batching){
+        undo_log.push({at, true, edit_group, std::string(text)});
+    }
+    else if(last && last->insertion && last->group == edit_group
+            && last->index + static_cast<int>(last->text.size()) == at){
+        std::size_t old_length = last->text.size();
+        last->text.append(text);
+        undo_log.update(old_length);
+    }
+    else{
+        undo_log.push({at, true, ++edit_group, std::string(text)});
+    }
+}
+
+void TextBuffer::record_remove(int at, const std::string &text){
+    if(!journaling) return;
+    redo_log.clear();
+    UndoLog::Edit *last = undo_log.newest();
+    int length = text.size();
+    if(batching){
+        undo_log.push({at, false, edit_group, text});
+    }
+    else if(last && !last->insertion && last->group == edit_group
+            && last->index == at){
+        // repeated delete at the same position
+        std::size_t old_length = last->text.size();
+        last->text.append(text);
+        undo_log.update(old_length);
+    }
+    else if(last && !last->insertion && last->group == edit_group
+            && last->index == at + length){
+        // repeated backspace
+        std::size_t old_length = last->text.size();
+        last->text.insert(0, text);
+        last->index = at;
+        undo_log.update(old_length);
+    }
+    else{
+        undo_log.push({at, false, ++edit_group, text});
+    }
+}
+
+void TextBuffer::horspool_shifts(std::string_view needle,
+                                 Direction direction, int *shift){
+    // distance to shift the window for each character at its end
+    // (FORWARD) or start (BACKWARD)
+    int length = needle.size();
+    std::fill(shift, shift + 256, length);
+    if(direction == FORWARD){
+        for(int i = 0; i < length - 1; i++){
+            shift[static_cast<unsigned char>(needle[i])] = length - 1 - i;
+        }
+    }
+    else{
+        for(int i = length - 1; i > 0; i--){
+            shift[static_cast<unsigned char>(needle[i])] = i;
+        }
+    }
+}
+
+int TextBuffer::find_forward(std::string_view needle, const int *shift,
+                             ConstIterator &last, int last_index) const{
+    int size = data->size();
+    int length = needle.size();
+    while(true){
+        ConstIterator it = last;
+        for(int i = length - 1; *it == needle[i]; i--, it--){
+            if(i == 0){
+                return last_index - length + 1;
+            }
+        }
+        int skip = shift[static_cast<unsigned char>(*last)];
+        if(last_index + skip >= size){
+            return -1;
+        }
+        last_index += skip;
+        for(; skip > 0; skip--){
+            ++last;
+        }
+    }
+}
+
+void TextBuffer::detach(){
+    if(data.use_count() == 1) return;
+    std::shared_ptr<CharList> copy = std::make_shared<CharList>();
+    Iterator new_cursor = copy->end();
+
+    // relocate marks in index order during the copy
+    std::vector<std::pair<int, int>> order;
+    for(std::size_t i = 0; i < marks.size(); i++){
+        if(marks[i].active){
+            order.push_back({marks[i].index, i});
+            marks[i].position = copy->end();
+        }
+    }
+    std::sort(order.begin(), order.end());
+    std::size_t next_mark = 0;
+
+    int i = 0;
+    for(Iterator it = data->begin(); it != data->end(); ++it, ++i){
+        copy->push_back(*it);
+        Iterator last = copy->end();
+        --last;
+        if(it == cursor){
+            new_cursor = last;
+        }
+        for(; next_mark < order.size() && order[next_mark].first == i;
+            next_mark++){
+            marks[order[next_mark].second].position = last;
+        }
+    }
+    data = copy;
+    cursor = new_cursor;
+}
+
+void TextBuffer::apply_edit(const UndoLog::Edit &edit, bool revert){
+    if(edit.insertion == revert){
+        remove_range(edit.index, edit.index + edit.text.size());
+    }
+    else{
+        seek_index(edit.index);
+        insert(edit.text);
+        if(revert){
+            seek_index(edit.index);
+        }
+    }
+}
+
+void TextBuffer::begin_batch(){
+    batching = true;
+    edit_group++;
+}
+
+void TextBuffer::end_batch(){
+    batching = false;
+    edit_group++;
+}
+
+std::vector<int> TextBuffer::cursor_positions() const{
+    std::vector<int> positions = cursors;
+    auto pos = std::lower_bound(positions.begin(), positions.end(), index);
+    if(pos == positions.end() || *pos != index){
+        positions.insert(pos, index);
+    }
+    return positions;
+}
+
+void TextBuffer::shift_cursors(int at, int delta){
+    if(cursors.empty()) return;
+    for(int &pos : cursors){
+        if(delta > 0 && pos >= at){
+            pos += delta;
+        }
+        else if(delta < 0 && pos > at){
+            pos = std::max(at, pos + delta);
+        }
+    }
+    cursors.erase(std::unique(cursors.begin(), cursors.end()),
+                  cursors.end());
+}
+
+void TextBuffer::shift_marks(int at, int delta, int rows, Iterator next){
+    // everything before at and after the replaced characters is unchanged
+    clean_prefix = std::min(clean_prefix, at);
+    clean_suffix = std::min<int>(clean_suffix,
+                                 data->size() - at - std::max(delta, 0));
+    for(Mark &mark : marks){
+        if(!mark.active || mark.index < at) continue;
+        if(delta > 0 || mark.index >= at - delta){
+            mark.index += delta;
+            mark.row += rows;
+        }
+        else{
+            // the mark's character was removed
+            if(mark.index > at){
+                mark.row = row;
+            }
+            mark.index = at;
+            mark.position = next;
+        }
+    }
+}
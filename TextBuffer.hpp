@@ -10,24 +10,63 @@
  */
 
 #include <list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 // Uncomment the following line to use your List implementation
 #include "List.hpp"
+#include "Regex.hpp"
+#include "UndoLog.hpp"
 
 class TextBuffer {
+public:
+  // Direction in which find() searches.
+  enum Direction { FORWARD, BACKWARD };
+
+  // The characters in [begin, end).
+  struct Range {
+    int begin;
+    int end;
+  };
+
+private:
   // Comment out the following two lines and uncomment the two below
   // to use your List implementation
   //using CharList = std::list<char>;
   //using Iterator = std::list<char>::iterator;
+  //using ConstIterator = std::list<char>::const_iterator;
   using CharList = List<char>;
   using Iterator = List<char>::Iterator;
+  using ConstIterator = List<char>::Iterator;
 
 private:
-  CharList data;           // linked list that contains the characters
+  std::shared_ptr<CharList> data; // linked list that contains the
+                                  // characters, shared with snapshots
   Iterator cursor;         // iterator to current element in the list
   int row;                 // current row
   int column;              // current column
   int index;               // current index
+  int newlines;            // number of '\n' characters in the list
+  UndoLog undo_log;        // edits that undo() reverts, newest last
+  UndoLog redo_log;        // edits that redo() reapplies, newest last
+  bool journaling;         // whether edits are recorded in undo_log
+  bool batching;           // whether edits are recorded as one group
+  int edit_group;          // undo group of the newest recorded edit
+  std::vector<int> cursors; // indices of secondary cursors, ascending
+  bool utf8;               // whether columns count UTF-8 codepoints
+  int clean_length;        // size of the contents at mark_clean()
+  int clean_prefix;        // leading characters unchanged since then
+  int clean_suffix;        // trailing characters unchanged since then
+
+  // A saved position that follows its character through edits.
+  struct Mark {
+    Iterator position;     // character the mark is on
+    int index;             // index of that character
+    int row;               // row of that character
+    bool active;           // whether the handle is in use
+  };
+  std::vector<Mark> marks; // marks, indexed by handle
 
   // INVARIANT (cursor iterator):
   //   `cursor` points at an actual character in the list, or is
@@ -37,13 +76,30 @@ private:
   //   `row` and `column` are the row and column numbers of the
   //   character the cursor is pointing at, determined by the
   //   placement of '\n' newline characters in the buffer.
-  //   row is 1-indexed, whereas column is 0-indexed.
+  //   row is 1-indexed, whereas column is 0-indexed. In UTF-8 mode,
+  //   column counts the bytes before the cursor in its row that are
+  //   not continuation bytes (see set_utf8()).
 
   // INVARIANT: (index)
   //   `index` is the 0-based index of the character the cursor is
   //   pointing at, or equal to the total number of characters in the
   //   list if the cursor is at the past-the-end position.
-  //   0 <= index <= data.size()
+  //   0 <= index <= data->size()
+
+  // INVARIANT: (data)
+  //   `data` is never null. If it is shared with a Snapshot, it is not
+  //   modified; the buffer copies it first (see detach()).
+
+  // INVARIANT: (newlines)
+  //   `newlines` is the number of '\n' characters in the list, so the
+  //   buffer has newlines + 1 rows.
+
+  // INVARIANT: (clean range)
+  //   The first clean_prefix characters match the first clean_prefix
+  //   characters of the contents at the last mark_clean(), and the last
+  //   clean_suffix characters match the last clean_suffix characters of
+  //   those contents. Both are at most the smaller of size() and
+  //   clean_length, though the two ranges may overlap.
 
   // The above invariants are established by the constructor and are
   // assumed to hold at the start of any member function call (i.e.
@@ -84,6 +140,21 @@ public:
   //          if appropriate to maintain all invariants.
   void insert(char c);
 
+  //MODIFIES: *this
+  //EFFECTS:  Inserts the given characters in the buffer before the cursor
+  //          position, in order, as if by calling insert(c) for each one.
+  //          The row, column, and index are updated once for the whole
+  //          run, and the run is a single undo entry.
+  void insert(std::string_view text);
+
+  //MODIFIES: *this
+  //EFFECTS:  Adds the given characters to the end of the buffer, for
+  //          loading a file in pieces. The cursor stays on the same
+  //          character, or at the past-the-end position if it was there.
+  //          Appending is not recorded for undo; existing undo and redo
+  //          entries are unaffected.
+  void append(std::string_view text);
+
   //MODIFIES: *this
   //EFFECTS:  Removes the character from the buffer that is at the cursor and
   //          returns true, unless the cursor is at the past-the-end position,
@@ -95,6 +166,137 @@ public:
   //          if appropriate to maintain all invariants.
   bool remove();
 
+  //REQUIRES: n >= 0
+  //MODIFIES: *this, *removed
+  //EFFECTS:  Removes up to n characters starting at the cursor, stopping
+  //          early at the past-the-end position, and returns the number
+  //          of characters removed. If removed is not null, the removed
+  //          characters are appended to it. The cursor will now point to
+  //          the character that was after the removed span, or the
+  //          past-the-end position. The span is unlinked in one operation.
+  //NOTE:     The row, column, and index of the cursor do not change.
+  int remove(int n, std::string *removed = nullptr);
+
+  //REQUIRES: 0 <= begin_index <= end_index <= size()
+  //MODIFIES: *this, *removed
+  //EFFECTS:  Moves the cursor to begin_index and removes the characters
+  //          in the range [begin_index, end_index), as if by remove(n).
+  //          Returns the number of characters removed.
+  int remove_range(int begin_index, int end_index,
+                   std::string *removed = nullptr);
+
+  //MODIFIES: *this
+  //EFFECTS:  Reverts the most recent run of edits that has not been
+  //          undone and returns true, or returns false if there is none.
+  //          Consecutive insertions, and consecutive removals at or just
+  //          before the same position, are coalesced into one run, which
+  //          is reverted by a single bulk insertion or removal. The
+  //          cursor moves to the start of the reverted run.
+  bool undo();
+
+  //MODIFIES: *this
+  //EFFECTS:  Reapplies the most recently undone run of edits and returns
+  //          true, or returns false if there is none. Any other edit
+  //          discards the runs that could be redone. The cursor moves to
+  //          where it was after the run was originally made.
+  bool redo();
+
+  //REQUIRES: 0 <= at <= size()
+  //MODIFIES: *this
+  //EFFECTS:  Adds a secondary cursor at the given index. Secondary
+  //          cursors are plain indices: ordinary edits shift them by
+  //          offset arithmetic, and cursors that end up at the same index
+  //          merge into one.
+  void add_cursor(int at);
+
+  //MODIFIES: *this
+  //EFFECTS:  Removes all secondary cursors.
+  void clear_cursors();
+
+  //EFFECTS:  Returns the indices of the secondary cursors in increasing
+  //          order.
+  const std::vector<int> & get_cursors() const;
+
+  //MODIFIES: *this
+  //EFFECTS:  Inserts text before the cursor and before every secondary
+  //          cursor in a single pass over the buffer. Each cursor remains
+  //          on the character it was on, and all of the insertions are
+  //          one undo entry.
+  void insert_at_cursors(std::string_view text);
+
+  //MODIFIES: *this
+  //EFFECTS:  Removes the character at the cursor and at every secondary
+  //          cursor in a single pass over the buffer, skipping cursors at
+  //          the past-the-end position, and returns the number of
+  //          characters removed. All of the removals are one undo entry.
+  int remove_at_cursors();
+
+  //MODIFIES: *this
+  //EFFECTS:  Places a mark on the character at the cursor (or the
+  //          past-the-end position) and returns a handle to it. The mark
+  //          stays on that character as text is inserted and removed
+  //          around it. If the character is removed, the mark moves to
+  //          the character that followed it.
+  int set_mark();
+
+  //REQUIRES: mark is a handle returned by set_mark() that has not been
+  //          cleared
+  //MODIFIES: *this
+  //EFFECTS:  Moves the cursor to the given mark. The mark keeps its own
+  //          iterator, index, and row, so only the column is recomputed.
+  void goto_mark(int mark);
+
+  //REQUIRES: mark is a handle returned by set_mark() that has not been
+  //          cleared
+  //EFFECTS:  Returns the index of the character the mark is on.
+  int get_mark_index(int mark) const;
+
+  //REQUIRES: mark is a handle returned by set_mark() that has not been
+  //          cleared
+  //MODIFIES: *this
+  //EFFECTS:  Removes the given mark. Its handle may be returned by a
+  //          later call to set_mark().
+  void clear_mark(int mark);
+
+  //MODIFIES: *this
+  //EFFECTS:  Sets the number of bytes of undo and redo entries kept in
+  //          memory. Older entries beyond that are spilled to a temporary
+  //          file if spill is true, or discarded otherwise. A limit of 0
+  //          with spill false turns off undo for this buffer.
+  void set_undo_limit(std::size_t bytes, bool spill);
+
+  //MODIFIES: *this
+  //EFFECTS:  Discards all undo and redo entries.
+  void clear_undo();
+
+  //MODIFIES: *this
+  //EFFECTS:  Removes all of the contents, secondary cursors, and undo and
+  //          redo entries, e.g. to load other contents, keeping settings
+  //          such as the undo limit and UTF-8 mode. Marks move to the
+  //          past-the-end position. Snapshots keep the old contents.
+  void clear();
+
+  //MODIFIES: *this
+  //EFFECTS:  Turns UTF-8 mode on or off. In UTF-8 mode, forward(),
+  //          backward(), and remove() step over a whole encoded
+  //          codepoint, and columns count codepoints rather than bytes.
+  //          Indices and sizes still count bytes. Each step still takes
+  //          constant time, since a codepoint is at most four bytes.
+  //          UTF-8 mode is off by default.
+  void set_utf8(bool on);
+
+  //EFFECTS:  Returns whether UTF-8 mode is on.
+  bool is_utf8() const;
+
+  //EFFECTS:  Returns the number of bytes that forward() would move over:
+  //          0 at the past-the-end position, otherwise 1, or in UTF-8
+  //          mode the length of the codepoint at the cursor.
+  int char_size() const;
+
+  //EFFECTS:  Returns whether c starts a column: any character, or in
+  //          UTF-8 mode a byte that is not a continuation byte.
+  bool starts_column(char c) const;
+
   //MODIFIES: *this
   //EFFECTS:  Moves the cursor to the start of the current row (column 0).
   //NOTE:     Your implementation must update the row, column, and index
@@ -145,6 +347,83 @@ public:
   //          if appropriate to maintain all invariants.
   bool down();
 
+  //REQUIRES: 0 <= new_index <= size()
+  //MODIFIES: *this
+  //EFFECTS:  Moves the cursor to the given index. The cursor walks from
+  //          the start of the buffer, its current position, or the end
+  //          of the buffer, whichever is closest to new_index, and the
+  //          column is recomputed once at the destination rather than at
+  //          every row crossed.
+  void seek_index(int new_index);
+
+  //REQUIRES: new_column >= 0
+  //MODIFIES: *this
+  //EFFECTS:  Moves the cursor to the given row and column and returns
+  //          whether the row exists. A row past the last row moves to
+  //          the last row, and a row before the first moves to the
+  //          first. As with move_to_column(), a row that does not have
+  //          that many columns moves to the end of the row. The cursor
+  //          walks from the first row, its current row, or the last row,
+  //          whichever is closest to new_row.
+  bool seek_row_col(int new_row, int new_column);
+
+  //REQUIRES: 0 <= fraction <= 1
+  //MODIFIES: *this
+  //EFFECTS:  Moves the cursor to the given fraction of the way through
+  //          the buffer, as if by seek_index().
+  void seek_fraction(double fraction);
+
+  //EFFECTS:  Returns the index of the first occurrence of needle that
+  //          starts at or after from_index, searching FORWARD, or the
+  //          last one that starts at or before from_index, searching
+  //          BACKWARD, or -1 if there is none. An empty needle matches
+  //          at from_index. The cursor does not move. This uses
+  //          Boyer-Moore-Horspool, which compares from the end of each
+  //          window and skips ahead by the last character's offset in
+  //          needle, so most characters are passed over without being
+  //          compared.
+  int find(std::string_view needle, int from_index,
+           Direction direction = FORWARD) const;
+
+  //MODIFIES: pattern (its DFA cache), *match_end
+  //EFFECTS:  Returns the index of the leftmost-longest match of pattern
+  //          that starts at or after from_index, or -1 if there is none,
+  //          without moving the cursor. If match_end is not null, sets it
+  //          to the index just past the match. The buffer is searched in
+  //          place, without copying it into a string.
+  int find(Regex &pattern, int from_index, int *match_end = nullptr) const;
+
+  //MODIFIES: pattern (its DFA cache)
+  //EFFECTS:  Returns the non-overlapping matches of pattern in the whole
+  //          buffer, in order, found in a single pass. After an empty
+  //          match, the search resumes one character later.
+  std::vector<Range> find_all(Regex &pattern) const;
+
+  //REQUIRES: ranges are sorted, do not overlap, and lie within
+  //          [0, size()]
+  //MODIFIES: *this
+  //EFFECTS:  Replaces the characters in each range with replacement and
+  //          returns the number of ranges. The ranges are rewritten from
+  //          last to first, so the cursor walks the buffer only once, and
+  //          each one is a single bulk removal and insertion. All of the
+  //          replacements are one undo entry. The cursor stays on the
+  //          character it was on; if that character is replaced, the
+  //          cursor moves to just after the replacement.
+  int replace_ranges(const std::vector<Range> &ranges,
+                     std::string_view replacement);
+
+  //MODIFIES: *this
+  //EFFECTS:  Replaces every occurrence of needle, scanning from the
+  //          start of the buffer without overlaps, and returns the
+  //          number replaced. Text inserted by a replacement is not
+  //          searched again. The buffer is rewritten in a single pass
+  //          that relinks each hit in place. The cursor, marks, and
+  //          secondary cursors are fixed up during the pass rather than
+  //          by seeking. The affected span is one undo entry. The cursor
+  //          stays on the character it was on; if that character is
+  //          replaced, the cursor moves to just after the replacement.
+  int replace_all(std::string_view needle, std::string_view replacement);
+
   //EFFECTS:  Returns whether the cursor is at the past-the-end position.
   bool is_at_end() const;
 
@@ -166,17 +445,261 @@ public:
   //EFFECTS:  Returns the number of characters in the buffer.
   int size() const;
 
+  //EFFECTS:  Returns the number of rows in the buffer.
+  int num_rows() const;
+
   //EFFECTS:  Returns the contents of the text buffer as a string.
   //HINT: Implement this using the string constructor that takes a
   //      begin and end iterator. You may use this implementation:
-  //        return std::string(data.begin(), data.end());
+  //        return std::string(data->begin(), data->end());
   std::string stringify() const;
 
+  // A read-only view of a range of characters in a TextBuffer. A View
+  // refers to the characters in place rather than copying them, so it
+  // is invalidated by any operation that modifies the buffer.
+  class View {
+  public:
+    class Iterator {
+    public:
+      Iterator() {}
+
+      const char & operator*() const {
+        return *it;
+      }
+
+      Iterator & operator++() {
+        ++it;
+        return *this;
+      }
+
+      Iterator operator++(int) {
+        Iterator temp = *this;
+        ++it;
+        return temp;
+      }
+
+      Iterator & operator--() {
+        --it;
+        return *this;
+      }
+
+      Iterator operator--(int) {
+        Iterator temp = *this;
+        --it;
+        return temp;
+      }
+
+      bool operator==(const Iterator &rhs) const {
+        return it == rhs.it;
+      }
+
+      bool operator!=(const Iterator &rhs) const {
+        return it != rhs.it;
+      }
+
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type = char;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const char*;
+      using reference = const char&;
+
+    private:
+      TextBuffer::ConstIterator it;
+
+      friend class View;
+      explicit Iterator(TextBuffer::ConstIterator it_in) : it(it_in) {}
+    };
+
+    //EFFECTS: Returns an iterator to the first character in the view.
+    Iterator begin() const {
+      return Iterator(first);
+    }
+
+    //EFFECTS: Returns an iterator past the last character in the view.
+    Iterator end() const {
+      return Iterator(last);
+    }
+
+    //EFFECTS: Returns the number of characters in the view.
+    int size() const {
+      return length;
+    }
+
+    //EFFECTS: Returns whether the view contains no characters.
+    bool empty() const {
+      return length == 0;
+    }
+
+    //EFFECTS: Copies the characters in the view into a string.
+    std::string str() const;
+
+  private:
+    TextBuffer::ConstIterator first;
+    TextBuffer::ConstIterator last;
+    int length;
+
+    friend class TextBuffer;
+    View(TextBuffer::ConstIterator first_in, TextBuffer::ConstIterator last_in,
+         int length_in)
+      : first(first_in), last(last_in), length(length_in) {}
+  };
+
+  //EFFECTS:  Returns a view of the entire contents of the buffer.
+  View view() const;
+
+  //REQUIRES: 0 <= begin_index <= end_index <= size()
+  //EFFECTS:  Returns a view of the characters in the range
+  //          [begin_index, end_index), without moving the cursor.
+  //          Locating the range walks from whichever of the start,
+  //          cursor, or end of the buffer is closest to begin_index.
+  View view(int begin_index, int end_index) const;
+
+  //REQUIRES: first_row >= 1
+  //EFFECTS:  Returns views of the rows from first_row on, at most count
+  //          of them and none past the last row, without moving the
+  //          cursor. Each view includes the newline that ends its row, if
+  //          any. The rows are found in one forward pass after walking to
+  //          first_row from whichever of the start, cursor, or end of the
+  //          buffer is closest.
+  std::vector<View> row_views(int first_row, int count) const;
+
+  // An immutable copy of the contents of a TextBuffer. Taking a Snapshot
+  // does not copy anything: it shares the buffer's list, and the buffer
+  // copies the list before its next modification if a Snapshot still
+  // refers to it. A Snapshot may be read on another thread while the
+  // buffer keeps changing.
+  class Snapshot {
+  public:
+    //EFFECTS: Returns a view of the entire contents of the snapshot.
+    View view() const;
+
+    //EFFECTS: Returns the number of characters in the snapshot.
+    int size() const;
+
+    //EFFECTS: Returns the contents of the snapshot as a string.
+    std::string stringify() const;
+
+  private:
+    std::shared_ptr<const CharList> data;
+
+    friend class TextBuffer;
+    explicit Snapshot(std::shared_ptr<const CharList> data_in)
+      : data(data_in) {}
+  };
+
+  //EFFECTS:  Returns a snapshot of the current contents in O(1) time.
+  //          The first modification of the buffer made while a snapshot
+  //          is alive copies the list once.
+  Snapshot snapshot() const;
+
+  //MODIFIES: *this
+  //EFFECTS:  Makes the current contents the clean contents, e.g. once
+  //          they match a file on disk, so that changed_range() starts
+  //          out empty. A new buffer is clean while empty, and text
+  //          added by append() counts as clean.
+  void mark_clean();
+
+  //EFFECTS:  Returns a range of the contents outside of which nothing
+  //          has changed since mark_clean(): the characters before begin
+  //          match the start of the clean contents, and the characters
+  //          from end on match its end. The range is empty if nothing
+  //          changed, and may be larger than what did change (e.g. edits
+  //          that were undone still count).
+  Range changed_range() const;
+
+  //EFFECTS:  Returns the size of the clean contents.
+  int clean_size() const;
+
 private:
   //EFFECTS: Computes the column of the cursor within the current row.
   //NOTE: This does not assume that the "column" member variable has
   //      a correct value (i.e. the row/column INVARIANT can be broken).
   int compute_column() const;
+
+  //EFFECTS:  Returns the number of columns in text.
+  int count_columns(std::string_view text) const;
+
+  //REQUIRES: 0 <= target_index <= size()
+  //EFFECTS:  Returns an iterator to the character at the given index,
+  //          walking from the start, the cursor, or the end of the
+  //          buffer, whichever is closest.
+  ConstIterator iterator_at(int target_index) const;
+
+  //REQUIRES: 1 <= target_row <= num_rows()
+  //EFFECTS:  Returns an iterator to the first character of the given
+  //          row, walking from the start, the cursor, or the end of the
+  //          buffer, whichever is closest.
+  ConstIterator row_start(int target_row) const;
+
+  //EFFECTS:  Fills shift, which has 256 entries, with the
+  //          Boyer-Moore-Horspool shift for each character at the end
+  //          (FORWARD) or start (BACKWARD) of a window.
+  static void horspool_shifts(std::string_view needle, Direction direction,
+                              int *shift);
+
+  //REQUIRES: needle is not empty, shift is from horspool_shifts() for
+  //          FORWARD, and last is the iterator at last_index, the end of
+  //          the first window to try
+  //MODIFIES: last
+  //EFFECTS:  Returns the index of the first occurrence of needle that
+  //          ends at or after last_index, leaving last at its final
+  //          character, or returns -1 if there is none.
+  int find_forward(std::string_view needle, const int *shift,
+                   ConstIterator &last, int last_index) const;
+
+  //REQUIRES: starts are the indices, before the rewrite, of the hits of
+  //          a replace_all() that has just been done
+  //MODIFIES: *this
+  //EFFECTS:  Records the rewritten span as one undo group.
+  void record_replace_all(const std::vector<int> &starts,
+                          std::string_view needle,
+                          std::string_view replacement);
+
+  //MODIFIES: *this
+  //EFFECTS:  If the list is shared with a Snapshot, replaces it with a
+  //          copy that only this buffer owns, keeping the cursor at the
+  //          same position. Called before every modification.
+  void detach();
+
+  //MODIFIES: *this
+  //EFFECTS:  Records that text was inserted at the given index, extending
+  //          the newest undo entry if it ends there. Discards redo entries.
+  void record_insert(int at, std::string_view text);
+
+  //MODIFIES: *this
+  //EFFECTS:  Records that text was removed from the given index, extending
+  //          the newest undo entry if it was a removal at or just after
+  //          that index. Discards redo entries.
+  void record_remove(int at, const std::string &text);
+
+  //MODIFIES: *this
+  //EFFECTS:  Reapplies the given edit, or reverts it if revert is true,
+  //          without recording it.
+  void apply_edit(const UndoLog::Edit &edit, bool revert);
+
+  //MODIFIES: *this
+  //EFFECTS:  Starts or ends a batch of edits that are recorded as one
+  //          undo group.
+  void begin_batch();
+  void end_batch();
+
+  //EFFECTS:  Returns the indices of the cursor and the secondary cursors
+  //          in increasing order, without duplicates.
+  std::vector<int> cursor_positions() const;
+
+  //MODIFIES: *this
+  //EFFECTS:  Updates the secondary cursors after delta characters were
+  //          inserted (delta > 0) or removed (delta < 0) at index at.
+  void shift_cursors(int at, int delta);
+
+  //REQUIRES: removals of more than one character start at the cursor
+  //MODIFIES: *this
+  //EFFECTS:  Updates the marks and the clean range after delta characters
+  //          containing rows newlines were inserted (delta > 0) or
+  //          removed (delta < 0, rows <= 0) at index at. Marks on removed
+  //          characters move to next, the character after the removed
+  //          ones; next is not used for insertions.
+  void shift_marks(int at, int delta, int rows, Iterator next);
 };
 
 #endif // TEXTBUFFER_HPP
@@ -0,0 +1,181 @@
+#include "UndoLog.hpp"
+#include <utility>
+
+UndoLog::UndoLog()
+  : bytes(0), limit(DEFAULT_LIMIT), spill_enabled(true),
+    spill_file(nullptr)
+{}
+
+UndoLog::~UndoLog() {
+    clear();
+}
+
+UndoLog::UndoLog(const UndoLog &other)
+  : bytes(0), limit(DEFAULT_LIMIT), spill_enabled(true),
+    spill_file(nullptr) {
+    copy_all(other);
+}
+
+UndoLog & UndoLog::operator=(const UndoLog &other) {
+    if(this == &other) return *this;
+    clear();
+    copy_all(other);
+    return *this;
+}
+
+bool UndoLog::empty() const {
+    return entries.empty() && spill_offsets.empty();
+}
+
+int UndoLog::size() const {
+    return entries.size() + spill_offsets.size();
+}
+
+std::size_t UndoLog::memory_used() const {
+    return bytes;
+}
+
+UndoLog::Edit * UndoLog::newest() {
+    if(entries.empty()){
+        return nullptr;
+    }
+    return &entries.back();
+}
+
+int UndoLog::newest_group() {
+    if(!entries.empty()){
+        return entries.back().group;
+    }
+    if(spill_offsets.empty()){
+        return -1;
+    }
+    long end = std::ftell(spill_file);
+    int group = read_entry(spill_file, spill_offsets.back()).group;
+    std::fseek(spill_file, end, SEEK_SET);
+    return group;
+}
+
+void UndoLog::update(std::size_t old_length) {
+    bytes += entries.back().text.size();
+    bytes -= old_length;
+    enforce_limit();
+}
+
+void UndoLog::push(Edit edit) {
+    bytes += cost(edit);
+    entries.push_back(std::move(edit));
+    enforce_limit();
+}
+
+UndoLog::Edit UndoLog::pop() {
+    if(entries.empty()){
+        return unspill();
+    }
+    Edit edit = std::move(entries.back());
+    entries.pop_back();
+    bytes -= cost(edit);
+    return edit;
+}
+
+void UndoLog::clear() {
+    entries.clear();
+    bytes = 0;
+    spill_offsets.clear();
+    if(spill_file){
+        std::fclose(spill_file);
+        spill_file = nullptr;
+    }
+}
+
+void UndoLog::set_limit(std::size_t bytes_in, bool spill_in) {
+    limit = bytes_in;
+    spill_enabled = spill_in;
+    enforce_limit();
+}
+
+std::size_t UndoLog::cost(const Edit &edit) {
+    return sizeof(Edit) + edit.text.size();
+}
+
+void UndoLog::enforce_limit() {
+    // always keep the newest entry so that it can still be extended
+    while(bytes > limit && entries.size() > 1){
+        Edit &oldest = entries.front();
+        if(!spill_enabled || !spill(oldest)){
+            // entries older than a dropped one can no longer be undone
+            spill_offsets.clear();
+        }
+        bytes -= cost(oldest);
+        entries.pop_front();
+    }
+    if(limit == 0 && !spill_enabled){
+        entries.clear();
+        bytes = 0;
+    }
+}
+
+bool UndoLog::spill(const Edit &edit) {
+    if(!spill_file){
+        spill_file = std::tmpfile();
+        if(!spill_file) return false;
+    }
+    long offset = spill_offsets.empty() ? 0 : std::ftell(spill_file);
+    int length = edit.text.size();
+    char insertion = edit.insertion;
+    if(std::fseek(spill_file, offset, SEEK_SET) != 0
+       || std::fwrite(&edit.index, sizeof(edit.index), 1, spill_file) != 1
+       || std::fwrite(&insertion, sizeof(insertion), 1, spill_file) != 1
+       || std::fwrite(&edit.group, sizeof(edit.group), 1, spill_file) != 1
+       || std::fwrite(&length, sizeof(length), 1, spill_file) != 1
+       || std::fwrite(edit.text.data(), 1, length, spill_file)
+            != static_cast<std::size_t>(length)){
+        return false;
+    }
+    spill_offsets.push_back(offset);
+    return true;
+}
+
+UndoLog::Edit UndoLog::unspill() {
+    long offset = spill_offsets.back();
+    spill_offsets.pop_back();
+    Edit edit = read_entry(spill_file, offset);
+    // the next spilled entry overwrites this one
+    std::fseek(spill_file, offset, SEEK_SET);
+    return edit;
+}
+
+UndoLog::Edit UndoLog::read_entry(std::FILE *file, long offset) {
+    Edit edit = {0, false, 0, ""};
+    int length = 0;
+    char insertion = 0;
+    std::fseek(file, offset, SEEK_SET);
+    if(std::fread(&edit.index, sizeof(edit.index), 1, file) == 1
+       && std::fread(&insertion, sizeof(insertion), 1, file) == 1
+       && std::fread(&edit.group, sizeof(edit.group), 1, file) == 1
+       && std::fread(&length, sizeof(length), 1, file) == 1){
+        edit.insertion = insertion;
+        edit.text.resize(length);
+        length = std::fread(&edit.text[0], 1, length, file);
+        edit.text.resize(length);
+    }
+    return edit;
+}
+
+void UndoLog::copy_all(const UndoLog &other) {
+    limit = other.limit;
+    spill_enabled = other.spill_enabled;
+    if(other.spill_file){
+        // read the other log's spilled entries back in order
+        long end = std::ftell(other.spill_file);
+        for(long offset : other.spill_offsets){
+            if(!spill(read_entry(other.spill_file, offset))){
+                spill_offsets.clear();
+            }
+        }
+        std::fseek(other.spill_file, end, SEEK_SET);
+    }
+    for(const Edit &edit : other.entries){
+        entries.push_back(edit);
+        bytes += cost(edit);
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef UNDOLOG_HPP
+#define UNDOLOG_HPP
+/* UndoLog.hpp
+ *
+ * Append-only stack of text edits used by TextBuffer for undo and redo.
+ * Entries stay in memory up to a configurable limit; beyond that, the
+ * oldest entries are spilled to a temporary file (or dropped if
+ * spilling is disabled) and read back when the stack unwinds to them.
+ *
+ * EECS 280 List/Editor Project
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+class UndoLog {
+public:
+  // A run of characters inserted into or removed from a buffer.
+  struct Edit {
+    int index;        // index of the first character of the run
+    bool insertion;   // whether the run was inserted (otherwise removed)
+    int group;        // edits with the same group are undone together
+    std::string text; // the inserted or removed characters
+  };
+
+  //EFFECTS: Creates an empty log with the default memory limit, which
+  //         spills to a temporary file.
+  UndoLog();
+
+  ~UndoLog();
+
+  UndoLog(const UndoLog &other);
+
+  UndoLog & operator=(const UndoLog &other);
+
+  //EFFECTS: Returns whether the log has no entries, including spilled
+  //         entries.
+  bool empty() const;
+
+  //EFFECTS: Returns the number of entries, including spilled entries.
+  int size() const;
+
+  //EFFECTS: Returns the number of bytes the in-memory entries use.
+  std::size_t memory_used() const;
+
+  //EFFECTS: Returns a pointer to the newest entry if it is held in
+  //         memory, or a null pointer otherwise. The entry may be
+  //         modified (e.g. to extend it); call update() afterward.
+  Edit * newest();
+
+  //EFFECTS: Returns the group of the newest entry, reading it from the
+  //         spill file if necessary, or -1 if the log is empty.
+  int newest_group();
+
+  //REQUIRES: the newest entry was just modified through newest(), and
+  //          old_length was the length of its text beforehand
+  //MODIFIES: *this
+  //EFFECTS:  Accounts for the change in size of the newest entry,
+  //          spilling or dropping the oldest entries if the memory
+  //          limit is now exceeded.
+  void update(std::size_t old_length);
+
+  //MODIFIES: *this
+  //EFFECTS:  Adds an entry as the newest one, spilling or dropping the
+  //          oldest entries if the memory limit is exceeded.
+  void push(Edit edit);
+
+  //REQUIRES: !empty()
+  //MODIFIES: *this
+  //EFFECTS:  Removes and returns the newest entry, reading it back from
+  //          the spill file if necessary.
+  Edit pop();
+
+  //MODIFIES: *this
+  //EFFECTS:  Removes all entries and discards the spill file.
+  void clear();
+
+  //MODIFIES: *this
+  //EFFECTS:  Sets the number of bytes of entries to keep in memory, and
+  //          whether entries beyond that are spilled to a temporary
+  //          file or dropped. A limit of 0 with spilling disabled turns
+  //          the log off.
+  void set_limit(std::size_t bytes, bool spill);
+
+  // Default number of bytes of entries kept in memory.
+  static const std::size_t DEFAULT_LIMIT = 16 << 20;
+
+private:
+  std::deque<Edit> entries;        // in-memory entries, oldest first
+  std::size_t bytes;               // memory used by entries
+  std::size_t limit;               // maximum for bytes
+  bool spill_enabled;              // spill entries beyond limit to a file
+  std::FILE *spill_file;           // spilled entries, oldest first
+  std::vector<long> spill_offsets; // file offset of each spilled entry
+
+  //EFFECTS: Returns the number of bytes an entry accounts for.
+  static std::size_t cost(const Edit &edit);
+
+  //MODIFIES: *this
+  //EFFECTS:  Spills or drops the oldest in-memory entries until the
+  //          memory limit is met.
+  void enforce_limit();
+
+  //MODIFIES: *this
+  //EFFECTS:  Appends an entry to the spill file and returns whether it
+  //          was written.
+  bool spill(const Edit &edit);
+
+  //REQUIRES: spill_offsets is not empty
+  //MODIFIES: *this
+  //EFFECTS:  Removes and returns the newest spilled entry.
+  Edit unspill();
+
+  //REQUIRES: offset is the offset of an entry in file
+  //EFFECTS:  Reads the entry at the given offset.
+  static Edit read_entry(std::FILE *file, long offset);
+
+  //REQUIRES: this log is empty
+  //EFFECTS:  Copies all entries and settings from other to this.
+  void copy_all(const UndoLog &other);
+};
+
+#endif // UNDOLOG_HPP
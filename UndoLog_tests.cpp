@@ -0,0 +1,128 @@
+#include "UndoLog.hpp"
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helper: build an edit
+static UndoLog::Edit edit(int index, bool insertion, const string &text,
+                          int group = 0) {
+    return UndoLog::Edit{index, insertion, group, text};
+}
+
+TEST(test_push_pop_order) {
+    UndoLog log;
+    ASSERT_TRUE(log.empty());
+    log.push(edit(0, true, "abc"));
+    log.push(edit(3, false, "d"));
+    ASSERT_EQUAL(log.size(), 2);
+
+    UndoLog::Edit e = log.pop();
+    ASSERT_EQUAL(e.index, 3);
+    ASSERT_FALSE(e.insertion);
+    ASSERT_EQUAL(e.text, string("d"));
+    e = log.pop();
+    ASSERT_EQUAL(e.index, 0);
+    ASSERT_TRUE(e.insertion);
+    ASSERT_EQUAL(e.text, string("abc"));
+    ASSERT_TRUE(log.empty());
+    ASSERT_EQUAL(log.memory_used(), 0u);
+}
+
+TEST(test_newest_and_update) {
+    UndoLog log;
+    ASSERT_TRUE(log.newest() == nullptr);
+    log.push(edit(0, true, "a"));
+    size_t used = log.memory_used();
+    UndoLog::Edit *newest = log.newest();
+    newest->text += "bc";
+    log.update(1);
+    ASSERT_EQUAL(log.memory_used(), used + 2);
+    ASSERT_EQUAL(log.pop().text, string("abc"));
+}
+
+TEST(test_spill_and_read_back) {
+    UndoLog log;
+    log.set_limit(2 * sizeof(UndoLog::Edit) + 16, true);
+    for (int i = 0; i < 20; ++i) {
+        log.push(edit(i, i % 2 == 0, string(i + 1, 'a' + i)));
+    }
+    ASSERT_EQUAL(log.size(), 20);
+    ASSERT_TRUE(log.memory_used() <= 2 * sizeof(UndoLog::Edit) + 16);
+
+    // entries come back newest first, across the memory/spill boundary
+    for (int i = 19; i >= 10; --i) {
+        UndoLog::Edit e = log.pop();
+        ASSERT_EQUAL(e.index, i);
+        ASSERT_EQUAL(e.insertion, i % 2 == 0);
+        ASSERT_EQUAL(e.text, string(i + 1, 'a' + i));
+    }
+    // spilling resumes where reading back left off
+    log.push(edit(100, true, "new"));
+    log.push(edit(101, true, "newer"));
+    ASSERT_EQUAL(log.pop().index, 101);
+    ASSERT_EQUAL(log.pop().index, 100);
+    for (int i = 9; i >= 0; --i) {
+        UndoLog::Edit e = log.pop();
+        ASSERT_EQUAL(e.index, i);
+        ASSERT_EQUAL(e.text, string(i + 1, 'a' + i));
+    }
+    ASSERT_TRUE(log.empty());
+}
+
+TEST(test_newest_group_reads_spilled_entry) {
+    UndoLog log;
+    ASSERT_EQUAL(log.newest_group(), -1);
+    log.set_limit(sizeof(UndoLog::Edit) + 8, true);
+    log.push(edit(0, true, "a", 7));
+    log.push(edit(1, true, "b", 8));
+    ASSERT_EQUAL(log.newest_group(), 8);
+    UndoLog::Edit e = log.pop();
+    ASSERT_EQUAL(e.group, 8);
+    // the remaining entry was spilled
+    ASSERT_EQUAL(log.newest_group(), 7);
+    e = log.pop();
+    ASSERT_EQUAL(e.group, 7);
+    ASSERT_EQUAL(e.text, string("a"));
+    ASSERT_EQUAL(log.newest_group(), -1);
+}
+
+TEST(test_limit_without_spill_drops_oldest) {
+    UndoLog log;
+    log.set_limit(3 * sizeof(UndoLog::Edit) + 3, false);
+    for (int i = 0; i < 10; ++i) {
+        log.push(edit(i, true, "x"));
+    }
+    ASSERT_EQUAL(log.size(), 3);
+    ASSERT_EQUAL(log.pop().index, 9);
+    ASSERT_EQUAL(log.pop().index, 8);
+    ASSERT_EQUAL(log.pop().index, 7);
+    ASSERT_TRUE(log.empty());
+}
+
+TEST(test_zero_limit_turns_log_off) {
+    UndoLog log;
+    log.set_limit(0, false);
+    log.push(edit(0, true, "x"));
+    ASSERT_TRUE(log.empty());
+    ASSERT_TRUE(log.newest() == nullptr);
+}
+
+TEST(test_copy_includes_spilled_entries) {
+    UndoLog log;
+    log.set_limit(sizeof(UndoLog::Edit) + 8, true);
+    for (int i = 0; i < 5; ++i) {
+        log.push(edit(i, true, "xy"));
+    }
+    UndoLog copy(log);
+    UndoLog assigned;
+    assigned = log;
+    for (int i = 4; i >= 0; --i) {
+        ASSERT_EQUAL(log.pop().index, i);
+        ASSERT_EQUAL(copy.pop().index, i);
+        ASSERT_EQUAL(assigned.pop().index, i);
+    }
+    ASSERT_TRUE(copy.empty());
+    ASSERT_TRUE(assigned.empty());
+}
+
+TEST_MAIN()
@@ -44,10 +44,11 @@ void render_buf(TextBuffer &buffer, WINDOW *window) {
   wmove(window, 0, 0);
   werase(window);
 
-  std::string data = buffer.stringify();
+  TextBuffer::View data = buffer.view();
   int cursor = buffer.get_index();
-  for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-    char c = data[i];
+  int i = 0;
+  for (auto it = data.begin(); it != data.end(); ++it, ++i) {
+    char c = *it;
     // The display character is either ' ' (if it's a newline) or the char
     // The display character is what gets highlighted if we're at the point
     int display = c == '\n' ? ' ' : c;
@@ -10,21 +10,44 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
-#include <deque>
 #include <iostream>
-#include <fstream>
+#include <limits>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <fcntl.h>
 #include <ncurses.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "TextBuffer.hpp"
+#include "Autosave.hpp"
+#include "ByteScan.hpp"
+#include "Editor.hpp"
+#include "Histogram.hpp"
+#include "KeyBindings.hpp"
+#include "KeyLog.hpp"
+#include "MappedFile.hpp"
+#include "Profile.hpp"
+#include "SafeFile.hpp"
 
 #ifndef FEMTO_INPUT_MODE // default to terminal input mode
 #  define FEMTO_INPUT_MODE TERMINAL
 #endif
 
-class FemtoEditor {
+#ifndef FEMTO_SYNC_ON_SAVE // default to flushing saves to the disk
+#  define FEMTO_SYNC_ON_SAVE true
+#endif
+
+#ifndef FEMTO_AUTOSAVE_SECONDS // seconds between recovery copies, or 0
+#  define FEMTO_AUTOSAVE_SECONDS 30
+#endif
+
+class FemtoEditor : public Editor {
 public:
   static constexpr const char *version = "2.80";
 
@@ -33,16 +56,49 @@ public:
     RAW       // control keys are passed uninterpreted to FEMTO
   };
 
-  // Initialize the editor with the given file and input mode.
-  // Starts the interaction.
-  FemtoEditor(std::string filename_in, InputMode input_mode_in)
-    : baseline(1), cursor_row(1), filename(filename_in),
-      modified(false), percentage(0), status("initial"),
-      input_mode(input_mode_in) {
+  // How to run the editor, as given on the command line.
+  struct Options {
+    InputMode input_mode = FEMTO_INPUT_MODE;
+    std::string key_file;       // keys to replay without a terminal
+    bool show_profile = false;  // whether to show frame times
+    std::string trace_file;     // where to write a trace of timings
+    std::string log_file;       // where to record the keys typed
+  };
+
+  // Initialize the editor with the given file and options.
+  // Starts the interaction. If a key file is given, its keys are
+  // replayed without a terminal instead. Timings are reported on exit
+  // if they were taken.
+  FemtoEditor(std::string filename_in, const Options &options)
+    : Editor(filename_in), cursor_row(1), percentage(0),
+      status("initial"), loaded(0),
+      after_cr(false), on_disk(false), autosave_pending(false),
+      damaged_begin(1), damaged_end(ALL_ROWS), bars_damaged(true),
+      rendered_baseline(0), show_profile(options.show_profile),
+      input_mode(options.input_mode) {
+    if (options.show_profile || !options.trace_file.empty()
+        || !options.key_file.empty()) {
+      profile = std::make_unique<Profile>(stage_names());
+      if (!options.trace_file.empty()) {
+        profile->trace_to(options.trace_file);
+      }
+      time_work(profile.get(),
+                {EDIT, EDIT, EDIT, SEARCH, SEARCH, EDIT, EDIT, SAVE});
+    }
+    if (!options.log_file.empty()) {
+      key_log = std::make_unique<KeyLogWriter>(options.log_file);
+    }
     if (!filename.empty()) {
       read_file();
     }
+    if (!options.key_file.empty()) {
+      start_replay(options.key_file);
+    }
     setup_windows();
+    if (!filename.empty() && !replay) {
+      start_autosave();
+      offer_recovery();
+    }
     interact();
   }
 
@@ -50,122 +106,55 @@ public:
   FemtoEditor(const FemtoEditor&) = delete;
   FemtoEditor& operator=(const FemtoEditor&) = delete;
 
-  // Shut down ncurses.
+  // Remove the recovery copy and shut down ncurses. Reports the
+  // timings, if they were taken.
   ~FemtoEditor() {
+    if (autosave) {
+      autosave->discard(); // exited deliberately, so nothing to recover
+    }
     curs_set(visibility); // restore prior visibility
+    std::fputs(PASTE_MODE_OFF, terminal_output());
     endwin();
+    if (replay) {
+      report_replay();
+    } else if (profile) {
+      profile->print(std::cout);
+    }
   }
 
 private:
   using clock_t = std::chrono::steady_clock;
   static constexpr double MESSAGE_TIMEOUT = 5; // time in seconds
-  static const std::size_t MAX_SHORT_STRING_LENGTH = 20;
-
-  struct KeyBindings {
-    static const int EXIT1 = 24; // ^X
-    static const int EXIT2 = 17; // ^Q
-    static const int SAVE1 = 1; // ^A
-    static const int SAVE2 = 19; // ^S
-    static const int SAVE3 = 15; // ^O - pico/nano binding
-    static const int REFRESH = 12; // ^L
-    static const int FIND1 = 6; // ^F
-    static const int FIND2 = 23; // ^W - pico/nano binding
-    static const int GOTO = 7; // ^G
-    static const int CUT = 11; // ^K
-    static const int UNCUT = 21; // ^U
-    static const int CANCEL = 14; // ^N
-    static const int INTERRUPT = 3; // ^C
-    static const int ESCAPE = 27;
-    static const int DELETE = 4; // ^D
-    static const int BACKSPACE2 = 127;
-    static const int BACKSPACE3 = '\b';
-    static const int NEWLINE = '\n';
-    static const int CARRIAGE_RETURN = '\r';
-    static const int WORD_LEFT1 = 542; // ^left on MacOS
-    static const int WORD_LEFT2 = 546; // ^left on Windows
-    static const int WORD_LEFT3 = 547; // ^left on MacOS (raw)
-    static const int WORD_RIGHT1 = 557; // ^right on MacOS
-    static const int WORD_RIGHT2 = 561; // ^right on Windows
-    static const int WORD_RIGHT3 = 562; // ^right on MacOS (raw)
-    static const int PAGE_DOWN = 526; // ^down on Windows
-    static const int PAGE_UP = 567; // ^up on Windows
-    static const int IGNORE1 = -1; // sent when mucking with the window
-    static const int IGNORE2 = 410; // sent when mucking with the window
-    static const int MIN_CHAR = 1;
-    static const int MAX_CHAR = 126;
-
-    static constexpr bool is_exit(int c) {
-      return c == EXIT1 || c == EXIT2 || c == INTERRUPT;
-    }
-    static constexpr bool is_save(int c) {
-      return c == SAVE1 || c == SAVE2 || c == SAVE3;
-    }
-    static constexpr bool is_refresh(int c) {
-      return c == REFRESH;
-    }
-    static constexpr bool is_goto(int c) {
-      return c == GOTO;
-    }
-    static constexpr bool is_find(int c) {
-      return c == FIND1 || c == FIND2;
-    }
-    static constexpr bool is_cut(int c) {
-      return c == CUT;
-    }
-    static constexpr bool is_uncut(int c) {
-      return c == UNCUT;
-    }
-    static constexpr bool is_cancel(int c) {
-      return c == CANCEL || c == INTERRUPT || c == ESCAPE;
-    }
-    static constexpr bool is_up(int c) {
-      return c == KEY_UP; // ncurses constant
-    }
-    static constexpr bool is_down(int c) {
-      return c == KEY_DOWN; // ncurses constant
-    }
-    static constexpr bool is_pageup(int c) {
-      return c == KEY_PPAGE /* ncurses constant */ || c == PAGE_UP;
-    }
-    static constexpr bool is_pagedown(int c) {
-      return c == KEY_NPAGE /* ncurses constant */ || c == PAGE_DOWN;
-    }
-    static constexpr bool is_enter(int c) {
-      return c == KEY_ENTER // ncurses constant
-        || c == NEWLINE || c == CARRIAGE_RETURN;
-    }
-    static constexpr bool is_backspace(int c) {
-      return c == KEY_BACKSPACE // ncurses constant
-        || c == BACKSPACE2 || c == BACKSPACE3;
-    }
-    static constexpr bool is_delete(int c) {
-      return c == KEY_DC /* ncurses constant */ || c == DELETE;
-    }
-    static constexpr bool is_left(int c) {
-      return c == KEY_LEFT; // ncurses constant
-    }
-    static constexpr bool is_right(int c) {
-      return c == KEY_RIGHT; // ncurses constant
-    }
-    static constexpr bool is_home(int c) {
-      return c == KEY_HOME; // ncurses constant
-    }
-    static constexpr bool is_end(int c) {
-      return c == KEY_END; // ncurses constant
-    }
-    static constexpr bool is_word_left(int c) {
-      return c == WORD_LEFT1 || c == WORD_LEFT2 || c == WORD_LEFT3;
-    }
-    static constexpr bool is_word_right(int c) {
-      return c == WORD_RIGHT1 || c == WORD_RIGHT2 || c == WORD_RIGHT3;
-    }
-    static constexpr bool is_ignore(int c) {
-      return c == IGNORE1 || c == IGNORE2;
-    }
+  static constexpr double MAX_BATCH_TIME = 0.1; // seconds of input
+                                                // handled per frame
+  // xterm sequences that turn bracketed paste mode on and off, and that
+  // the terminal sends around pasted text while it is on
+  static constexpr const char *PASTE_MODE_ON = "\033[?2004h";
+  static constexpr const char *PASTE_MODE_OFF = "\033[?2004l";
+  static constexpr const char *PASTE_START_SEQUENCE = "\033[200~";
+  static constexpr const char *PASTE_END_SEQUENCE = "\033[201~";
+  static constexpr std::size_t LOAD_CHUNK = 1 << 20; // bytes loaded at once
+  static constexpr const char *RECOVERY_SUFFIX = ".recover";
+  static constexpr int ALL_ROWS = std::numeric_limits<int>::max();
+  // terminal type a replay draws for, which also decodes its keys
+  static constexpr const char *REPLAY_TERMINAL = "xterm";
+
+  // Stages of work that are timed when profiling. A key is timed from
+  // when it is read until the next key is read or waited for, so the
+  // last key of a batch includes rendering the frame.
+  enum Stage {
+    KEY, INPUT, EDIT, SEARCH, LOAD, SAVE,
+    FRAME, REBASE, CANVAS, VIEW_COLUMN, BARS, UPDATE
   };
 
+  // Return the names of the stages, in order.
+  static std::vector<std::string> stage_names() {
+    return {"key", "input", "edit", "search", "load", "save",
+            "frame", "rebase", "canvas", "view column", "bars", "update"};
+  }
+
   struct Buffer {
-    TextBuffer text;
+    TextBuffer &text;
     WINDOW *window;
     bool reverse;        // whether A_REVERSE is set on the window
     std::string long_prefix; // prefix string before placing characters
@@ -195,61 +184,114 @@ private:
       }
     }
 
-    // Compute the new view column based on the cursor and move the
-    // text buffer to that position.
-    // REQUIRES: femto.text.get_row() == cursor_row
-    void recompute_view_column(FemtoEditor &femto, int cursor_row,
-                               int cursor_column) {
+    // Compute the new view column of the cursor row, whose text is
+    // row_text, based on the cursor column.
+    void recompute_view_column(FemtoEditor &femto, TextBuffer::View row_text) {
+      Profile::Timer timer(femto.profile.get(), VIEW_COLUMN);
+      int cursor_row = text.get_row();
+      int cursor_column = text.get_column();
       if (cursor_row != view_row || cursor_column < view_column) {
         view_row = cursor_row;
         view_column = 0; // recompute from the left
       }
-      text.move_to_column(view_column);
+      // first byte and column of each character up to the one after
+      // the cursor
+      std::vector<std::pair<char, int>> chars;
+      int column = 0;
+      for (auto it = row_text.begin();
+           it != row_text.end() && column <= cursor_column + 1; ) {
+        char c = femto.next_char(text, it, row_text.end());
+        chars.push_back({c, column});
+        column += text.starts_column(c);
+      }
+      std::size_t k = 0; // first character shown
+      for (; k < chars.size() && chars[k].second < view_column
+             && chars[k].first != '\n'; ++k);
       std::string &prefix = get_prefix();
       int window_width = getmaxx(window) - prefix.size() - 1;
       // column in the window where current character will be written
       int window_column = (view_column != 0 ? 1 : 0);
-      for (; text.get_column() <= cursor_column
-             && !text.is_at_end() // handle end of buffer
-             && text.get_row() == cursor_row; // handle end of row
-           text.forward()) {
-        char c = text.data_at_cursor();
+      for (; k < chars.size() && chars[k].second <= cursor_column; ++k) {
+        char c = chars[k].first;
         window_column += femto.display_width(window_column, c);
         if (window_column > window_width && c != '\n') {
           // slide view column to the right
-          window_width = getmaxx(window) - prefix.size() -  1;
           int remaining = window_width - 1; //right overflow marker
           // max of current char + 4 chars to the left of current
-          for (int i = 0, ichar = text.data_at_cursor();
-               i < 5 && remaining - femto.display_width(0, ichar) >= 0;
-               remaining -= femto.display_width(0, ichar), ++i,
-                 text.backward(), ichar = text.data_at_cursor());
-          text.forward(); // we went back too far by one character
-          view_column = text.get_column();
+          std::size_t first = k + 1;
+          for (int i = 0;
+               i < 5 && first > 0
+                 && remaining - femto.display_width(0, chars[first - 1].first)
+                    >= 0;
+               ++i) {
+            --first;
+            remaining -= femto.display_width(0, chars[first].first);
+          }
+          first = std::min(first, chars.size() - 1);
+          view_column = chars[first].second;
           // set window column after current character
-          window_column =
-            1 + femto.display_width(1, text.data_at_cursor());
+          window_column = 1 + femto.display_width(1, chars[first].first);
+          k = first;
         }
       }
-      if (text.get_row() != cursor_row) { // we moved to the next row
-        text.up();
-      }
-      text.move_to_column(view_column);
     }
   };
 
-  Buffer editbuffer = {{}, nullptr, false, "", "", 1, 0, '$', '$'};
-  Buffer minibuffer = {{}, nullptr, true, "", "", 1, 0, '<', '>'};
-  int baseline;         // row of top line in canvas
+  Buffer editbuffer = {text, nullptr, false, "", "", 1, 0, '$', '$'};
+  Buffer minibuffer = {prompt_text, nullptr, true, "", "", 1, 0, '<', '>'};
   int cursor_row;
-  std::string filename;
-  bool modified;        // whether or not the text has been modified
   int percentage;       // how far in the text the cursor is
   std::string status;   // file modification status
   std::string message;  // info/error message
   std::chrono::time_point<clock_t> message_time;
-  std::string cut_value;
-  std::string previous_search;
+  std::unique_ptr<MappedFile> loading; // file still being loaded, if any
+  std::size_t loaded;   // bytes of the file loaded so far
+  bool after_cr;        // whether the last chunk loaded ended in a CR
+  std::string load_scratch; // chunk with its line endings converted
+  bool on_disk;         // whether the clean contents of the buffer are
+                        // exactly the bytes of the file in disk_info
+  struct stat disk_info; // the file when last loaded or saved
+  std::unique_ptr<Autosave> autosave; // writes recovery copies, if enabled
+  bool autosave_pending; // whether there are edits not yet autosaved
+  std::chrono::time_point<clock_t> autosave_time; // first such edit
+  int damaged_begin;    // first row of the text to redraw
+  int damaged_end;      // row after the last one to redraw
+  bool bars_damaged;    // whether the message and bottom bars need
+                        // redrawing regardless of the message
+  int rendered_baseline; // baseline when the canvas was last drawn
+  std::string shown_message; // message on the message bar
+  // Keys replayed from a file, with the screen drawn into curses' own
+  // model of it and the terminal output thrown away.
+  struct Replay {
+    std::FILE *keys = nullptr;   // the bytes a terminal would send
+    std::FILE *output = nullptr; // the null device
+    SCREEN *screen = nullptr;
+
+    Replay() = default;
+    Replay(const Replay&) = delete;
+    Replay& operator=(const Replay&) = delete;
+
+    ~Replay() {
+      if (screen) {
+        delscreen(screen);
+      }
+      if (output) {
+        std::fclose(output);
+      }
+      if (keys) {
+        std::fclose(keys);
+      }
+    }
+  };
+  // Thrown when a replay runs out of keys.
+  struct ReplayFinished {};
+
+  std::unique_ptr<Replay> replay; // set while replaying
+  std::unique_ptr<Profile> profile; // set while timing stages
+  bool show_profile;    // whether to show frame times on the screen
+  std::chrono::time_point<clock_t> key_time; // when the last key was read
+  bool timing_key = false; // whether the last key is being timed
+  std::unique_ptr<KeyLogWriter> key_log; // records the keys, if set
   WINDOW *main_window;
   WINDOW *canvas;
   WINDOW *top_bar;
@@ -263,7 +305,7 @@ private:
   // Initial curses setup.
   // look the other way if you've ever programmed using curses
   void setup_windows(bool highlight_canvas_cursor = true) {
-    main_window = initscr();
+    main_window = replay ? stdscr : initscr(); // a replay made its own
     if (input_mode == RAW) {
       raw();
     } else {
@@ -271,6 +313,11 @@ private:
     }
     noecho();
     keypad(main_window, true);
+    // have the terminal mark pastes, so they can be inserted in bulk
+    define_key(PASTE_START_SEQUENCE, KeyBindings::PASTE_START);
+    define_key(PASTE_END_SEQUENCE, KeyBindings::PASTE_END);
+    std::fputs(PASTE_MODE_ON, terminal_output());
+    std::fflush(terminal_output());
     visibility = curs_set(0);
 
     int ncols = getmaxx(main_window);
@@ -310,6 +357,13 @@ private:
       std::snprintf(buf, sizeof(buf) / sizeof(char), "%o", i);
       char_widths[i] = 1 + std::strlen(buf);
     }
+    if (utf8) {
+      // a codepoint takes the column of its lead byte (wide characters
+      // are not measured)
+      for (unsigned i = 0xC2; i <= 0xF4; ++i) {
+        char_widths[i] = 1;
+      }
+    }
     // Special handling for backspace and delete
     char_widths[static_cast<unsigned char>('\b')] = 2;
     char_widths[static_cast<unsigned char>('\x7f')] = 2;
@@ -317,303 +371,413 @@ private:
 
   // Render all windows.
   void render_all(bool highlight_canvas_cursor = true) {
-    render_canvas(highlight_canvas_cursor);
+    damage_all();
+    render_changes(highlight_canvas_cursor);
+  }
+
+  // Render the damaged rows of the canvas and the bars that changed, and
+  // refresh only those windows. The top bars show the cursor position,
+  // so they are always rendered.
+  void render_changes(bool highlight_canvas_cursor = true) {
+    Profile::Timer timer(profile.get(), FRAME);
+    if (damaged_begin < damaged_end || baseline != rendered_baseline) {
+      render_canvas(highlight_canvas_cursor);
+      wnoutrefresh(canvas);
+    }
+    {
+      Profile::Timer bars_timer(profile.get(), BARS);
+      render_top_bars();
+      wnoutrefresh(top_bar);
+      wnoutrefresh(overflow_bar);
+      if (bars_damaged || message != shown_message) {
+        render_message_bar();
+        wnoutrefresh(message_bar);
+      }
+      if (bars_damaged) {
+        render_bottom_bar();
+        wnoutrefresh(bottom_bar);
+      }
+      bars_damaged = false;
+    }
+    Profile::Timer update_timer(profile.get(), UPDATE);
+    doupdate();
+  }
+
+  // Mark the rows from first up to (not including) end for redrawing.
+  void damage_rows(int first, int end) {
+    damaged_begin = std::min(damaged_begin, first);
+    damaged_end = std::max(damaged_end, end);
+  }
+
+  // Mark the whole screen for redrawing.
+  void damage_all() {
+    damage_rows(1, ALL_ROWS);
+    bars_damaged = true;
+  }
+
+  // Mark the rows that moving the cursor or editing at it may have
+  // changed, given the cursor row and the number of rows before.
+  void damage_cursor_rows(int old_row, int old_rows) {
+    int row = editbuffer.text.get_row();
+    if (editbuffer.text.num_rows() != old_rows) {
+      damage_rows(std::min(old_row, row), ALL_ROWS); // later rows moved
+    } else {
+      damage_rows(old_row, old_row + 1);
+      damage_rows(row, row + 1);
+    }
+  }
+
+  // Redraw the cursor row without highlighting the cursor, e.g. while
+  // prompting in the minibuffer.
+  void unhighlight_cursor() {
+    damage_cursor_rows(editbuffer.text.get_row(),
+                       editbuffer.text.num_rows());
+    render_canvas(false);
     wrefresh(canvas);
-    render_top_bars();
-    wrefresh(top_bar);
-    wrefresh(overflow_bar);
-    render_message_bar();
-    wrefresh(message_bar);
-    render_bottom_bar();
-    wrefresh(bottom_bar);
   }
 
   // Main interaction loop -- respond to user input.
   void interact() {
-    do {
-      render_all();
-    } while (handle_edit_input(getch()));
+    try {
+      do {
+        load_ahead();
+        report_autosave_error();
+        render_changes();
+      } while (handle_input_batch());
+    } catch (const ReplayFinished &) {
+      // ran out of keys to replay
+    }
+    finish_key();
   }
 
-  // Handle an input character in the edit buffer. Returns whether or
-  // not interaction should continue.
-  bool handle_edit_input(int c) {
-    clear_message();
-    if (KeyBindings::is_exit(c)) {
-      return !handle_exit();
-    } else if (KeyBindings::is_save(c)) {
-      set_modified(!handle_save(), true);
-    } else if (KeyBindings::is_goto(c)) {
-      handle_goto();
-    } else if (KeyBindings::is_find(c)) {
-      handle_find();
-    } else if (KeyBindings::is_cut(c)) {
-      return handle_cut();
-    } else if (KeyBindings::is_uncut(c)) {
-      handle_uncut();
-    } else if (KeyBindings::is_up(c)) {
-      editbuffer.text.up();
-    } else if (KeyBindings::is_down(c)) {
-      editbuffer.text.down();
-    } else if (KeyBindings::is_pageup(c)) {
-      move_page(2 - getmaxy(canvas));
-    } else if (KeyBindings::is_pagedown(c)) {
-      move_page(getmaxy(canvas) - 2);
-    } else {
-      set_modified(handle_buffer_input(editbuffer, c,
-                                       KeyBindings::MIN_CHAR,
-                                       KeyBindings::MAX_CHAR));
+  // Handle the next input character and any input already waiting
+  // behind it, so that a burst of input (e.g. a paste) is rendered
+  // once rather than once per character. Stops after MAX_BATCH_TIME so
+  // that a steady stream still shows progress. A replay renders after
+  // every key, so that each is timed as a frame of its own. Returns
+  // whether or not interaction should continue.
+  bool handle_input_batch() {
+    if (!handle_edit_input(next_input())) {
+      return false;
+    } else if (replay) {
+      return true;
+    }
+    auto start = clock_t::now();
+    int c;
+    while (seconds_since(start) < MAX_BATCH_TIME
+           && (c = pending_input()) != ERR) {
+      load_ahead();
+      if (!handle_edit_input(c)) {
+        return false;
+      }
     }
     return true;
   }
 
-  // Handle an input character for the given buffer. Returns whether
-  // or not the buffer was modified.
-  bool handle_buffer_input(Buffer &buffer, int c,
-                           int min_char, int max_char,
-                           bool highlight_canvas_cursor = true) {
-    if (KeyBindings::is_refresh(c)) {
-      endwin();
-      setup_windows(highlight_canvas_cursor);
-    } else if (KeyBindings::is_delete(c)) {
-      return buffer.text.remove();
-    } else if (KeyBindings::is_backspace(c)) {
-      if (buffer.text.backward()) { // make sure there is a character
-        buffer.text.remove();
-        return true;
+  // Read the rest of a bracketed paste, up to the sequence that ends
+  // it. The text is read through curses, like any other input, so that
+  // keys typed after the paste stay queued and decoded as they arrive;
+  // only the rendering is skipped until the whole paste is inserted.
+  // Keys decoded within the text are dropped, since they cannot be
+  // typed.
+  std::string read_paste() override {
+    std::string paste;
+    int c;
+    while ((c = getch()) != KeyBindings::PASTE_END && c != ERR) {
+      if (c <= KeyBindings::MAX_UTF8_BYTE) {
+        paste.push_back(c);
       }
-    } else if (KeyBindings::is_left(c)) {
-      buffer.text.backward();
-    } else if (KeyBindings::is_right(c)) {
-      buffer.text.forward();
-    } else if (KeyBindings::is_home(c)) {
-      buffer.text.move_to_row_start();
-    } else if (KeyBindings::is_end(c)) {
-      buffer.text.move_to_row_end();
-    } else if (KeyBindings::is_enter(c)) {
-      buffer.text.insert('\n'); // convert to newline
-      return true;
-    } else if (KeyBindings::is_word_left(c)) {
-      // skip over alphanumeric characters
-      while (is_alphanumeric(buffer) && buffer.text.backward());
-      // skip over non-alphanumeric characters
-      while (!is_alphanumeric(buffer) && buffer.text.backward());
-    } else if (KeyBindings::is_word_right(c)) {
-      // skip over alphanumeric characters
-      while (is_alphanumeric(buffer) && buffer.text.forward());
-      // skip over non-alphanumeric characters
-      while (!is_alphanumeric(buffer) && buffer.text.forward());
-    } else if (KeyBindings::is_ignore(c)) { // do nothing
-    } else if (min_char <= c && c <= max_char) {
-      buffer.text.insert(c);
-      return true;
-    } else {
-      beep(); // reject and alert the user
     }
-    return false;
+    if (key_log) {
+      key_log->text(paste);
+    }
+    return paste;
   }
 
-  // Determine whether the cursor is over an alphanumeric character.
-  bool is_alphanumeric(Buffer &buffer) {
-    return !buffer.text.is_at_end()
-      && ((buffer.text.data_at_cursor() >= 'a'
-           && buffer.text.data_at_cursor() <= 'z')
-          || (buffer.text.data_at_cursor() >= 'A'
-              && buffer.text.data_at_cursor() <= 'Z')
-          || (buffer.text.data_at_cursor() >= '0'
-              && buffer.text.data_at_cursor() <= '9'));
-  }
-
-  // Read a line number in the minibuffer and go to that line.
-  void handle_goto() {
-    minibuffer.set_prefix("Goto line (^N to cancel): ", "Goto: ");
-    clear_line(minibuffer);
-    get_minibuffer_input('0', '9');
-    std::string input = minibuffer.text.stringify();
-    if (!input.empty()) {
-      try {
-        int target = std::stoi(input);
-        goto_line(target);
-      } catch (const std::out_of_range&) {
-        set_message("ERROR: Invalid integer", "Invalid integer");
-      }
-    } else {
-      set_message("Canceled", "Canceled");
-    }
+  // Return the next input character if one is waiting, or ERR.
+  int pending_input() {
+    nodelay(main_window, true);
+    int c = getch();
+    nodelay(main_window, false);
+    if (c != ERR) {
+      finish_key();
+    }
+    return start_key(c);
   }
 
-  // Read user input in the minibuffer. Return whether input was
-  // not canceled.
-  bool get_minibuffer_input(int min_char, int max_char) {
-    render_canvas(false); // unhighlight cursor
-    wrefresh(canvas);
-    render_minibuffer();
-    wrefresh(bottom_bar);
-    int input;
-    while (!KeyBindings::is_enter(input = getch())
-           && !KeyBindings::is_cancel(input)) {
-      handle_buffer_input(minibuffer, input, min_char, max_char, false);
-      render_minibuffer();
-      wrefresh(bottom_bar);
-    }
-    if (KeyBindings::is_cancel(input)) {
-      clear_line(minibuffer);
-      return false;
+  // Wait for the next input character. While the file is still being
+  // loaded, loads it a chunk at a time until a key is pressed. Edits
+  // are autosaved once they are due, even if no key is pressed. A
+  // replay never waits for keys, so it goes straight to the next one.
+  int next_input() {
+    if (replay) {
+      return read_key();
+    }
+    finish_key();
+    if (key_log) {
+      key_log->flush(); // keep the log of a session that crashes
+    }
+    nodelay(main_window, true);
+    int c = ERR;
+    while (loading && (c = getch()) == ERR) {
+      load_chunk();
+      render_top_bars();
+      wrefresh(top_bar);
+      wrefresh(overflow_bar);
+    }
+    int delay;
+    while (c == ERR && (delay = autosave_delay()) >= 0) {
+      wtimeout(main_window, delay);
+      if ((c = getch()) == ERR) {
+        autosave->save(editbuffer.text.snapshot());
+        autosave_pending = false;
+      }
     }
-    return true;
+    nodelay(main_window, false);
+    if (c == ERR) {
+      c = getch(); // an idle autosave is written while waiting
+    }
+    if (autosave && autosave->release()) {
+      // the buffer now reuses its list rather than copying it on the next
+      // edit, and the snapshot that was not written is saved again at
+      // the next pause
+      autosave_pending = true;
+    }
+    return start_key(c);
   }
 
-  // Go to the start of a specific line in the text.
-  void goto_line(int target) {
-    editbuffer.text.move_to_row_start();
-    while (editbuffer.text.get_row() < target
-           && editbuffer.text.down());
-    while (editbuffer.text.get_row() > target
-           && editbuffer.text.up());
+  // Read the next key, e.g. at a prompt. Running out of keys ends a
+  // replay.
+  int read_key() override {
+    finish_key();
+    int c = getch();
+    if (replay && c == ERR) {
+      throw ReplayFinished();
+    }
+    return start_key(c);
   }
 
-  // Read a search string in the minibuffer, attempt to find it, and
-  // if it is found, go to that location.
-  void handle_find() {
-    std::string prefix = "Search (^N to cancel)";
-    if (!previous_search.empty()) {
-      prefix += " [" + previous_search + "]: ";
-    } else {
-      prefix += ": ";
+  // Record the given key, which was just read, if recording, and
+  // start timing it, if profiling. Returns the key.
+  int start_key(int c) {
+    if (key_log && c != ERR) {
+      key_log->key(c);
     }
-    minibuffer.set_prefix(prefix, "Search: ");
-    clear_line(minibuffer);
-    if (!get_minibuffer_input(KeyBindings::MIN_CHAR,
-                              KeyBindings::MAX_CHAR)) {
-      set_message("Canceled", "Canceled");
-      return;
+    if (profile && c != ERR) {
+      key_time = clock_t::now();
+      timing_key = true;
     }
-    std::string search = minibuffer.text.stringify();
-    if (search.empty() && previous_search.empty()) {
-      set_message("Canceled", "Canceled");
-      return;
-    } else if (search.empty()) {
-      search = previous_search;
+    return c;
+  }
+
+  // Record the time taken by the key being timed, if any.
+  void finish_key() {
+    if (timing_key) {
+      profile->record(KEY, key_time, clock_t::now());
+      timing_key = false;
     }
-    previous_search = search;
+  }
 
-    // save old position, in case the string is not found
-    int old_row = editbuffer.text.get_row();
-    int old_column = editbuffer.text.get_column();
-    int old_index = editbuffer.text.get_index();
-    std::deque<char> search_deque{search.begin(), search.end()};
-    editbuffer.text.forward(); // skip current char
-    if (!find_helper(editbuffer.text, search_deque)) {
-      // try again from beginning
-      goto_line(1);
-      if (!find_helper(editbuffer.text, search_deque, old_index + 1)) {
-        set_message("\"" + shorten_string(search) + "\" not found",
-                    "Not found");
-        // restore old position
-        goto_line(old_row);
-        editbuffer.text.move_to_column(old_column);
-        return;
-      }
+  // Return the number of seconds since the given time.
+  static double seconds_since(std::chrono::time_point<clock_t> start) {
+    return std::chrono::duration<double>(clock_t::now() - start).count();
+  }
+
+  // Set up a replay of the keys in the given file. Curses draws for
+  // REPLAY_TERMINAL into the null device, on a screen of the size in
+  // the LINES and COLUMNS environment variables, or 24x80 by default.
+  void start_replay(const std::string &key_file) {
+    replay = std::make_unique<Replay>();
+    replay->keys = std::fopen(key_file.c_str(), "rb");
+    if (!replay->keys) {
+      throw std::runtime_error("Unable to read " + key_file);
+    }
+    replay->output = std::fopen("/dev/null", "w");
+    if (replay->output) {
+      replay->screen = newterm(REPLAY_TERMINAL, replay->output,
+                               replay->keys);
+    }
+    if (!replay->screen) {
+      throw std::runtime_error(std::string("Unable to set up a ")
+                               + REPLAY_TERMINAL + " screen for replay");
     }
-    // found string, need to move backwards to its beginning
-    for (std::size_t i = 1; i < search.size();
-         ++i, editbuffer.text.backward());
-    if (editbuffer.text.get_index() <= old_index) {
-      set_message("Search wrapped", "Search wrapped");
-    } else {
-      set_message("", "");
-    }
-  }
-
-  // Search the given buffer for the string. If max_index is provided,
-  // the search ends upon exceeding that position by the size of the
-  // search string.
-  bool find_helper(TextBuffer &text, const std::deque<char> &search,
-                   int max_index = -1) {
-    int size = search.size();
-    std::deque<char> window;
-    for (; !text.is_at_end()
-           && (max_index == -1 || text.get_index() < max_index + size);
-         text.forward()) {
-      if (window.size() == search.size()) {
-        window.pop_front();
-      }
-      window.push_back(text.data_at_cursor());
-      if (window == search) {
-        return true;
-      }
+  }
+
+  // Return the stream that sends output to the terminal, which a
+  // replay throws away.
+  std::FILE * terminal_output() {
+    return replay ? replay->output : stdout;
+  }
+
+  // Print the number of keys replayed, the distribution of their
+  // latencies, and the time spent in each stage.
+  void report_replay() {
+    const Histogram &keys = profile->histogram(KEY);
+    std::cout << "Replayed " << keys.count() << " keys in "
+              << Histogram::format(keys.total()) << "\n"
+              << "Key latency: p50 " << Histogram::format(keys.percentile(0.5))
+              << ", p90 " << Histogram::format(keys.percentile(0.9))
+              << ", p99 " << Histogram::format(keys.percentile(0.99))
+              << ", max " << Histogram::format(keys.max()) << "\n";
+    keys.print(std::cout);
+    profile->print(std::cout);
+  }
+
+  // Return the number of milliseconds until pending edits are due to be
+  // autosaved, or -1 if there is nothing to autosave. Nothing is
+  // autosaved while the file is loading, since the buffer only holds
+  // part of it.
+  int autosave_delay() {
+    if (!autosave || !autosave_pending || loading) {
+      return -1;
+    }
+    auto due = autosave_time + std::chrono::seconds(FEMTO_AUTOSAVE_SECONDS);
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       due - clock_t::now()).count();
+    return std::max<int>(remaining, 0);
+  }
+
+  // Start writing recovery copies of the buffer next to the file, if
+  // autosaving is enabled. The copies get the file's permissions, or are
+  // private to the user if the file does not exist yet.
+  void start_autosave() {
+    if (FEMTO_AUTOSAVE_SECONDS > 0) {
+      struct stat info;
+      mode_t mode = stat(filename.c_str(), &info) == 0
+                    ? info.st_mode & 0777 : 0600;
+      autosave = std::make_unique<Autosave>(filename + RECOVERY_SUFFIX,
+                                            mode);
+    }
+  }
+
+  // Show an error from the last autosave, if any.
+  void report_autosave_error() {
+    if (autosave && !autosave->take_error().empty()) {
+      set_message("ERROR: Unable to write " + shorten_string(autosave->path()),
+                  "Autosave FAILED");
     }
-    return false;
   }
 
-  // Clear the contents of the current line and return the contents.
-  std::string clear_line(Buffer &buffer) {
-    std::string line;
-    buffer.text.move_to_row_end();
-    if (buffer.text.forward()) {
-      line.push_back('\n');
-      buffer.text.backward();
-      buffer.text.remove();
-    }
-    bool moved = false;
-    while ((moved = buffer.text.backward())
-           && buffer.text.data_at_cursor() != '\n') {
-      line.push_back(buffer.text.data_at_cursor());
-      buffer.text.remove();
-    }
-    if (moved) {
-      buffer.text.forward(); // move back to start of line
-    }
-    std::reverse(line.begin(), line.end());
-    return line;
-  }
-
-  // Remove each line as long as CUT is input, saving them in
-  // cut_value. Handles the input following the last CUT and returns
-  // the result.
-  bool handle_cut() {
-    std::string new_cut_value;
-    int input = KeyBindings::CUT;
-    while (KeyBindings::is_cut(input)) {
-      std::string line = clear_line(editbuffer);
-      if (line.empty()) {
-        set_message("Nothing to cut", "Nothing to cut");
+  // Offer to restore the buffer from a recovery copy left behind by an
+  // earlier session. The answer is not logged as a key, since a replay
+  // has no recovery copy to ask about; a restore is logged as a
+  // RECOVERED key followed by the text restored instead.
+  void offer_recovery() {
+    struct stat info;
+    if (!autosave || stat(autosave->path().c_str(), &info) != 0) {
+      return;
+    }
+    prompt("Recovery file found. Restore it? (Y)es/(N)o ",
+           "Restore? (Y/N) ");
+    render_all(false); // unhighlight cursor
+    while (true) {
+      int c = getch();
+      if (c == 'y' || c == 'Y') {
+        break;
+      } else if (c == 'n' || c == 'N' || KeyBindings::is_cancel(c)) {
+        std::remove(autosave->path().c_str());
+        return;
+      } else {
+        beep(); // reject and alert the user
       }
-      new_cut_value += line;
-      set_modified(!new_cut_value.empty()); // update status before
-      render_all();                         // re-rendering
-      input = getch();
     }
-    if (!new_cut_value.empty()) {
-      cut_value = new_cut_value;
+    try {
+      auto recovered = std::make_unique<MappedFile>(autosave->path());
+      if (key_log) {
+        key_log->key(KeyBindings::RECOVERED);
+        key_log->text(recovered->view());
+      }
+      editbuffer.text.clear();
+      loading = std::move(recovered);
+      loaded = 0;
+      after_cr = false;
+      load_chunk();
+      on_disk = false;
+      editbuffer.text.seek_index(0);
+      set_modified();
+      set_message("Restored " + shorten_string(autosave->path()),
+                  "Restored");
+    } catch (const std::runtime_error &) {
+      set_message("ERROR: Unable to read " + shorten_string(autosave->path()),
+                  "Restore FAILED");
     }
-    return handle_edit_input(input); // handle last user input
   }
 
-  // Insert all characters from cut_value into the buffer.
-  void handle_uncut() {
-    for (std::size_t i = 0; i < cut_value.size(); ++i) {
-      editbuffer.text.insert(cut_value[i]);
-    }
-    set_modified(!cut_value.empty());
-    if (cut_value.empty()) {
-      set_message("Nothing to uncut", "Nothing to uncut");
+  // Handle an input character in the edit buffer, and mark what it
+  // changed for redrawing. Returns whether or not interaction should
+  // continue.
+  bool handle_edit_input(int c) override {
+    Profile::Timer timer(profile.get(), INPUT);
+    clear_message();
+    int old_row = editbuffer.text.get_row();
+    int old_rows = editbuffer.text.num_rows();
+    bool continuing = Editor::handle_edit_input(c);
+    if (KeyBindings::is_command(c)) {
+      damage_all();
+    } else {
+      damage_cursor_rows(old_row, old_rows); // only the cursor rows changed
     }
+    return continuing;
   }
 
-  // Mark buffer as modified if argument is true.
-  void set_modified(bool modify = true, bool force_overwrite = false) {
+  // Mark buffer as modified if modify is true, updating the status
+  // and scheduling an autosave.
+  void set_modified(bool modify = true,
+                    bool force_overwrite = false) override {
+    Editor::set_modified(modify, force_overwrite);
     if (modify) {
-      modified = true;
       status = "modified";
-    } else if (force_overwrite) {
-      modified = modify;
+      if (!autosave_pending) {
+        autosave_pending = true;
+        autosave_time = clock_t::now();
+      }
     }
   }
 
+  // Show a prompt's prefix in the minibuffer, and empty it.
+  void prompt(const std::string &long_prefix,
+              const std::string &short_prefix) override {
+    minibuffer.set_prefix(long_prefix, short_prefix);
+    Editor::prompt(long_prefix, short_prefix);
+  }
+
+  // Show the minibuffer with the prompt, unhighlighting the cursor in
+  // the canvas while the prompt has the input.
+  void show_prompt() override {
+    unhighlight_cursor();
+    show_minibuffer();
+  }
+
+  // Show the minibuffer as it changes.
+  void show_minibuffer() override {
+    render_minibuffer();
+    wrefresh(bottom_bar);
+  }
+
+  // Show the text between cuts.
+  void show_changes() override {
+    render_all();
+  }
+
+  // Reinitialize curses and redraw everything.
+  void refresh_screen(bool prompting) override {
+    endwin();
+    setup_windows(!prompting);
+  }
+
+  // Alert the user to a rejected key.
+  void reject_key() override {
+    beep();
+  }
+
+  // Return the number of rows of text the canvas shows.
+  int canvas_rows() const override {
+    return getmaxy(canvas);
+  }
+
   // Set message state and time.
   void set_message(const std::string &long_message,
-                   const std::string &short_message) {
+                   const std::string &short_message) override {
     if (static_cast<int>(long_message.size()) + 4 // [ and ] markers
         > getmaxx(message_bar)) {
       message = short_message;
@@ -626,90 +790,11 @@ private:
   // Clear message state.
   void clear_message() {
     if (!message.empty() // clear message after timeout has passed
-        && static_cast<std::chrono::duration<double>>( // seconds
-             clock_t::now() - message_time
-           ).count() > MESSAGE_TIMEOUT) {
+        && seconds_since(message_time) > MESSAGE_TIMEOUT) {
       message = "";
     }
   }
 
-  // Handle pageup and pagedown events.
-  void move_page(int offset) {
-    int column = editbuffer.text.get_column();
-    // move cursor first
-    while (editbuffer.text.get_row() < baseline + offset
-           && editbuffer.text.down()); // handle hitting the last row
-    while (editbuffer.text.get_row() > baseline + offset
-           && editbuffer.text.up()); // handle hitting the first row
-    // restore column
-    editbuffer.text.move_to_column(column);
-    // set new baseline
-    if (editbuffer.text.get_row() == 1) {
-      baseline = 1;
-    } else if (editbuffer.text.get_row() < baseline + offset) {
-      // page down at the bottom should not change view
-    } else {
-      baseline = editbuffer.text.get_row();
-    }
-  }
-
-  // Return shortened string (e.g. for filenames or messages).
-  std::string shorten_string(const std::string &original,
-                             std::size_t limit = MAX_SHORT_STRING_LENGTH) {
-    std::string result = original;
-    if (original.size() > limit) {
-      result = "...";
-      result += original.substr(original.size() - limit + result.size());
-    }
-    return result;
-  }
-
-  // Handle save dialogue.
-  bool handle_save() {
-    minibuffer.set_prefix("File to write (^N to cancel): ", "Save as: ");
-    clear_line(minibuffer);
-    // add existing filename to minibuffer
-    for (char ch : filename) {
-      minibuffer.text.insert(ch);
-    }
-    get_minibuffer_input(KeyBindings::MIN_CHAR, KeyBindings::MAX_CHAR);
-    std::string file_to_write = minibuffer.text.stringify();
-    if (!file_to_write.empty()) {
-      return write_file(file_to_write);
-    } else {
-      set_message("Canceled", "Canceled");
-      return !modified;
-    }
-  }
-
-  // Handle exit confirmation.
-  bool handle_exit() {
-    if (modified) {
-      minibuffer.set_prefix("Save modified buffer before "
-                            "exiting? (Y)es/(N)o/(C)ancel ",
-                            "Save? (Y/N/C) ");
-      clear_line(minibuffer);
-      render_canvas(false); // unhighlight cursor
-      wrefresh(canvas);
-      render_minibuffer();
-      wrefresh(bottom_bar);
-      while (true) {
-        int c = getch();
-        if (c == 'y' || c == 'Y') {
-          return handle_save();
-        } else if (c == 'n' || c == 'N') {
-          return true;
-        } else if (c == 'c' || c == 'C' || KeyBindings::is_cancel(c)) {
-          set_message("Canceled", "Canceled");
-          return false;
-        } else {
-          beep(); // reject and alert the user
-        }
-      }
-    }
-    return true;
-  }
-
   // Render the status/overflow bars at the top.
   void render_top_bars() {
     const char *femto_info = " U-M FEMTO ";
@@ -723,6 +808,10 @@ private:
       std::to_string(percentage) + "% ("
       + std::to_string(editbuffer.text.get_row()) + ","
       + std::to_string(editbuffer.text.get_column()) + ") ";
+    if (loading) {
+      position_info += "loading "
+        + std::to_string(100 * loaded / loading->size()) + "% ";
+    }
     reset_bar(top_bar);
     werase(overflow_bar);
     int info_length = std::strlen(femto_info) + file_info.size()
@@ -741,6 +830,24 @@ private:
       wattroff(overflow_bar, A_REVERSE);
     }
     wattroff(top_bar, A_REVERSE);
+    if (show_profile) {
+      render_frame_times();
+    }
+  }
+
+  // Show the median and 99th percentile time to render a frame at the
+  // right of the overflow bar, if they fit.
+  void render_frame_times() {
+    const Histogram &frames = profile->histogram(FRAME);
+    std::string times = " frame p50 "
+      + Histogram::format(frames.percentile(0.5)) + " p99 "
+      + Histogram::format(frames.percentile(0.99)) + " ";
+    int column = getmaxx(overflow_bar) - times.size();
+    if (column >= 0) {
+      wattron(overflow_bar, A_REVERSE);
+      mvwaddstr(overflow_bar, 0, column, times.c_str());
+      wattroff(overflow_bar, A_REVERSE);
+    }
   }
 
   // Reset given bar to be blank, with default position and attributes.
@@ -755,6 +862,7 @@ private:
 
   // Render the message bar near the bottom.
   void render_message_bar() {
+    shown_message = message;
     werase(message_bar);
     if (!message.empty()) {
       // center message
@@ -772,56 +880,70 @@ private:
   void render_bottom_bar() {
     reset_bar(bottom_bar);
     waddstr(bottom_bar,
-            " ^X exit | ^F find | ^A save | ^K cut | ^U uncut"
-            " | ^G goto | ^L redraw");
+            " ^X exit | ^F find | ^R regex | ^T replace | ^A save | ^K cut"
+            " | ^U uncut | ^G goto | ^B undo | ^Y redo | ^L redraw");
     wattroff(bottom_bar, A_REVERSE);
   }
 
   // Render the minibuffer at the bottom.
   void render_minibuffer() {
     reset_bar(bottom_bar);
-    std::string data = minibuffer.text.stringify();
-    int old_column = minibuffer.text.get_column();
-    render_row(minibuffer, 1, old_column, true);
+    render_row(minibuffer, 1, minibuffer.text.row_views(1, 1).front(), true);
     wattroff(bottom_bar, A_REVERSE);
-    minibuffer.text.move_to_column(old_column); // restore position
     if (minibuffer.text.is_at_end()) {
       waddch(bottom_bar, ' '|A_NORMAL);
     }
   }
 
-  // Render the canvas with the text data.
+  // Render the damaged rows of the canvas with the text data, or every
+  // row if the canvas scrolled. The rows are read in one pass, without
+  // moving the cursor.
   void render_canvas(bool highlight_cursor = true) {
-    wmove(canvas, 0, 0);
-    werase(canvas);
+    Profile::Timer timer(profile.get(), CANVAS);
+    TextBuffer &text = editbuffer.text;
     rebase();
-
-    // save current position
-    int old_row = editbuffer.text.get_row();
-    int old_column = editbuffer.text.get_column();
-    percentage = editbuffer.text.is_at_end() ? 100 :
-      100LL * editbuffer.text.get_index() / editbuffer.text.size();
-    // display as many rows as fit on the canvas, starting at baseline
-    for (int row = baseline; row < baseline + getmaxy(canvas); ++row) {
-      goto_line(row); // move to start of target row
-      if (editbuffer.text.get_row() == row) { // guard against end
-        render_row(editbuffer, old_row, old_column, highlight_cursor);
-      }
+    if (baseline != rendered_baseline) {
+      damage_rows(1, ALL_ROWS);
+      rendered_baseline = baseline;
     }
+    percentage = text.is_at_end() ? 100 :
+      100LL * text.get_index() / text.size();
 
-    // restore previous position
-    goto_line(old_row);
-    editbuffer.text.move_to_column(old_column);
-
-    if (highlight_cursor && editbuffer.text.is_at_end()) {
-      // add highlighted cursor at the end of the buffer
-      waddch(canvas, ' '|A_STANDOUT);
+    // display the damaged rows that fit on the canvas
+    int first = std::max(damaged_begin, baseline);
+    int end = std::min<long long>(damaged_end,
+                                  0LL + baseline + getmaxy(canvas));
+    while (loading && text.num_rows() < end) {
+      load_chunk(); // the last row must be complete
+    }
+    std::vector<TextBuffer::View> rows =
+      text.row_views(first, std::max(end - first, 0));
+    for (int row = first; row < end; ++row) {
+      wmove(canvas, row - baseline, 0);
+      wclrtoeol(canvas);
+      if (row - first < static_cast<int>(rows.size())) { // guard against end
+        render_row(editbuffer, row, rows[row - first], highlight_cursor);
+        if (highlight_cursor && text.is_at_end() && row == text.get_row()) {
+          // add highlighted cursor at the end of the buffer
+          waddch(canvas, ' '|A_STANDOUT);
+        }
+      }
     }
+    damaged_begin = ALL_ROWS;
+    damaged_end = 0;
   }
 
   // Handle character escaping when displaying to the given window.
-  void escape_char(WINDOW *window, char display, int attributes) {
-    if (display == '\b' || display == '\x7f') {
+  // continuation is the rest of a UTF-8 codepoint that starts with
+  // display, which is written unescaped for the terminal to decode.
+  void escape_char(WINDOW *window, char display, int attributes,
+                   std::string_view continuation = {}) {
+    if (!continuation.empty()) {
+      waddch(window, static_cast<unsigned char>(display)|attributes);
+      for (char byte : continuation) {
+        waddch(window, static_cast<unsigned char>(byte)|attributes);
+      }
+    } else if (display == '\b' || display == '\x7f') {
       // special handling for backspace and delete
       waddch(window, '^'|attributes);
       waddch(window, (display == '\b' ? 'H' : '?')|attributes);
@@ -840,15 +962,16 @@ private:
   }
 
   // Display a character in the window with proper highlighting.
-  void display_char(Buffer &buffer, char display, bool highlight) {
+  void display_char(Buffer &buffer, char display, bool highlight,
+                    std::string_view continuation = {}) {
     if (highlight && buffer.reverse) {
       wattroff(buffer.window, A_REVERSE);
-      escape_char(buffer.window, display, A_NORMAL);
+      escape_char(buffer.window, display, A_NORMAL, continuation);
       wattron(buffer.window, A_REVERSE);
     } else if (highlight) {
-      escape_char(buffer.window, display, A_STANDOUT);
+      escape_char(buffer.window, display, A_STANDOUT, continuation);
     } else {
-      escape_char(buffer.window, display, A_NORMAL);
+      escape_char(buffer.window, display, A_NORMAL, continuation);
     }
   }
 
@@ -862,27 +985,55 @@ private:
     }
   }
 
-  // Render the current buffer row in the window.
-  void render_row(Buffer &buffer, int cursor_row, int cursor_column,
+  // Return the character at it and move it past the character, which in
+  // UTF-8 mode is a whole codepoint, as TextBuffer::forward() moves.
+  // Sets continuation, if given, to the rest of the codepoint.
+  char next_char(const TextBuffer &text, TextBuffer::View::Iterator &it,
+                 TextBuffer::View::Iterator end,
+                 std::string *continuation = nullptr) {
+    char c = *it;
+    ++it;
+    if (continuation) {
+      continuation->clear();
+    }
+    for (int i = 0; i < 3 && it != end && !text.starts_column(*it); ++i) {
+      if (continuation) {
+        continuation->push_back(*it);
+      }
+      ++it;
+    }
+    return c;
+  }
+
+  // Render the given row of the buffer, whose text is row_text, in the
+  // window.
+  void render_row(Buffer &buffer, int row, TextBuffer::View row_text,
                   bool highlight_cursor) {
     int init_x, init_y;
     getyx(buffer.window, init_y, init_x); // initial location
-    render_current_row_prefix(buffer, cursor_row, cursor_column);
-    for (int current_row = buffer.text.get_row();
-         !buffer.text.is_at_end()
-           && buffer.text.get_row() == current_row;
-         buffer.text.forward()) {
-      char c = buffer.text.data_at_cursor();
+    bool cursor_row = row == buffer.text.get_row();
+    int cursor_column = buffer.text.get_column();
+    TextBuffer::View::Iterator it = row_text.begin();
+    int column = 0;
+    if (cursor_row) {
+      render_current_row_prefix(buffer, row_text);
+      // skip to the view column
+      while (it != row_text.end() && column < buffer.view_column
+             && *it != '\n') {
+        column += buffer.text.starts_column(next_char(buffer.text, it,
+                                                      row_text.end()));
+      }
+    }
+    std::string continuation; // the rest of a UTF-8 codepoint
+    while (it != row_text.end()) {
+      char c = next_char(buffer.text, it, row_text.end(), &continuation);
       // The display character is either ' ' (if it's a newline) or
       // the char. The display character is what gets highlighted if
       // the current position is at that point.
       char display = (c == '\n' || c == '\r') ? ' ' : c;
-      bool highlight = false;
-      if (highlight_cursor
-          && buffer.text.get_row() == cursor_row
-          && buffer.text.get_column() == cursor_column) {
-        highlight = true;
-      }
+      bool highlight = highlight_cursor && cursor_row
+                       && column == cursor_column;
+      column += buffer.text.starts_column(c);
 
       int x, y;
       getyx(buffer.window, y, x); // current location
@@ -895,43 +1046,38 @@ private:
         waddch(buffer.window, '\n');
       } else if (display_width(x, c) >= getmaxx(buffer.window) - x) {
         // Character goes off window
-        display_char(buffer, display, highlight);
+        display_char(buffer, display, highlight, continuation);
         wmove(buffer.window, init_y, getmaxx(buffer.window) - 1);
         waddch(buffer.window, buffer.right_overflow_marker);
         break;
       } else {
         // Show a regular character (common case)
-        display_char(buffer, display, highlight);
+        display_char(buffer, display, highlight, continuation);
       }
     }
   }
 
-  // Render the start of a row if it is the current row. Moves the
-  // buffer to the first character to be displayed.
-  void render_current_row_prefix(Buffer &buffer, int cursor_row,
-                                 int cursor_column) {
-    if (cursor_row == buffer.text.get_row()) {
-      // Show prefix
-      std::string &prefix = buffer.get_prefix();
-      for (std::size_t i = 0; i < prefix.size(); ++i) {
-        display_char(buffer, prefix[i], false);
-      }
-      // Handle showing subset of current line if it is too long
-      buffer.recompute_view_column(*this, cursor_row, cursor_column);
-      if (buffer.view_column != 0) {
-        // not showing line start - add marker
-        display_char(buffer, buffer.left_overflow_marker, false);
-      }
+  // Render the start of the current row, whose text is row_text, and
+  // update its view column.
+  void render_current_row_prefix(Buffer &buffer, TextBuffer::View row_text) {
+    // Show prefix
+    std::string &prefix = buffer.get_prefix();
+    for (std::size_t i = 0; i < prefix.size(); ++i) {
+      display_char(buffer, prefix[i], false);
+    }
+    // Handle showing subset of current line if it is too long
+    buffer.recompute_view_column(*this, row_text);
+    if (buffer.view_column != 0) {
+      // not showing line start - add marker
+      display_char(buffer, buffer.left_overflow_marker, false);
     }
   }
 
   // Move the baseline by half the window if the cursor is offscreen.
   // Also set the cursor row and reset the view column if needed.
   void rebase() {
-    if (editbuffer.text.get_row() < baseline
-        || editbuffer.text.get_row() >= baseline + getmaxy(canvas)) {
-      baseline =
-        std::max(1, editbuffer.text.get_row() - getmaxy(canvas) / 2);
+    Profile::Timer timer(profile.get(), REBASE);
+    if (recenter()) {
       wclear(canvas); // required for some terminals
     }
     if (editbuffer.text.get_row() != cursor_row) {
@@ -940,60 +1086,211 @@ private:
     }
   }
 
-  // Read initial contents of the file.
+  // Open the file and read its first chunk. The rest is loaded as it
+  // is needed or while waiting for input.
   void read_file() {
-    std::ifstream input(filename);
-    const std::streamsize SIZE = 128;
-    char arr[SIZE];
-    char last = '\0';
-    while (input) {
-      input.read(arr, SIZE);
-      for (std::streamsize i = 0; i < input.gcount(); ++i) {
-        // Convert CR and CRLF to just LF
-        if (last != '\r' || arr[i] != '\n') {
-          editbuffer.text.insert(arr[i] == '\r' ? '\n' : arr[i]);
-        }
-        last = arr[i];
-      }
+    try {
+      loading = std::make_unique<MappedFile>(filename);
+      loaded = 0;
+      after_cr = false;
+      on_disk = stat(filename.c_str(), &disk_info) == 0
+                && S_ISREG(disk_info.st_mode)
+                && static_cast<std::size_t>(disk_info.st_size)
+                   == loading->size();
+      load_chunk();
+    } catch (const std::runtime_error &) {
+      // a new file (or an unreadable one) starts out empty
     }
     // move to start of buffer
-    while (editbuffer.text.get_row() != 1) {
-      editbuffer.text.up();
+    editbuffer.text.seek_index(0);
+  }
+
+  // Append the next chunk of the file to the buffer, converting CR and
+  // CRLF to just LF.
+  void load_chunk() {
+    Profile::Timer timer(profile.get(), LOAD);
+    std::string_view contents = loading->view();
+    const char *begin = contents.data() + loaded;
+    const char *end =
+      begin + std::min(contents.size() - loaded, LOAD_CHUNK);
+    loaded = end - contents.data();
+    std::string_view chunk =
+      ByteScan::normalize_newlines(begin, end, load_scratch, after_cr);
+    // the chunk may continue the last row
+    damage_rows(editbuffer.text.num_rows(), ALL_ROWS);
+    if (chunk.data() != begin) {
+      on_disk = false; // line endings were converted
+    }
+    editbuffer.text.append(chunk);
+    if (loaded == contents.size()) {
+      loading.reset(); // done, so unmap the file
+    }
+  }
+
+  // Load the rest of the file.
+  void load_all() override {
+    while (loading) {
+      load_chunk();
+    }
+  }
+
+  // Load the file up to the given row, e.g. to go to it.
+  void load_rows(int rows) override {
+    while (loading && editbuffer.text.num_rows() < rows) {
+      load_chunk();
+    }
+  }
+
+  // Load enough of the file to fill the screen and to have a chunk
+  // loaded past the cursor.
+  void load_ahead() {
+    while (loading
+           && (editbuffer.text.size() - editbuffer.text.get_index()
+                 < static_cast<int>(LOAD_CHUNK)
+               || editbuffer.text.num_rows() < baseline + getmaxy(canvas))) {
+      load_chunk();
     }
-    editbuffer.text.move_to_row_start();
   }
 
-  // Write the contents of the buffer to the file.
-  bool write_file(const std::string &file_to_write) {
-    std::ofstream output(file_to_write);
-    std::string text = editbuffer.text.stringify();
-    if (output << text) {
-      filename = file_to_write;
+  // Write the contents of the buffer to the file. If only a small part
+  // of the file changed, and its size did not, that part is patched in
+  // place. Otherwise the contents are streamed to a temporary file that
+  // then replaces the file, so a failed save leaves the old contents
+  // intact. Returns whether or not the file was written.
+  bool write_file(const std::string &file_to_write) override {
+    load_all();
+    bool damaged = false; // whether a failed patch left the file damaged
+    try {
+      if (file_to_write != filename || !patch_file(damaged)) {
+        SafeFile output(file_to_write);
+        TextBuffer::View text = editbuffer.text.view();
+        output.write(text.begin(), text.end());
+        output.commit(FEMTO_SYNC_ON_SAVE);
+      }
+      editbuffer.text.mark_clean();
+      on_disk = stat(file_to_write.c_str(), &disk_info) == 0;
+      // the recovery copy is stale now; a new name gets a new copy
+      if (autosave) {
+        autosave->discard();
+      }
+      if (file_to_write != filename || !autosave) {
+        filename = file_to_write;
+        autosave.reset();
+        start_autosave();
+      }
+      autosave_pending = false;
       status = "saved";
       set_message("Wrote " + shorten_string(file_to_write),
                   "Wrote file");
       return true;
-    } else {
-      set_message("ERROR: Unable to write "
-                  + shorten_string(file_to_write),
-                  "Write FAILED");
+    } catch (const std::runtime_error &) {
+      if (damaged) {
+        on_disk = false; // never patch the damaged file again
+        set_message("ERROR: " + shorten_string(file_to_write)
+                    + " is DAMAGED; save again",
+                    "File DAMAGED");
+      } else {
+        set_message("ERROR: Unable to write "
+                    + shorten_string(file_to_write),
+                    "Write FAILED");
+      }
+    }
+    return false;
+  }
+
+  // Write just the changed range of the buffer over the file. Returns
+  // false without touching the file if the file is not the one the
+  // buffer was loaded from or last saved to, if its size changed (which
+  // would move everything after the change), or if the range does not
+  // fit in one chunk or is large enough that a full rewrite, which is
+  // atomic, costs about as much. The range is overwritten only once all
+  // of it, and the bytes it replaces, are in memory. If writing fails,
+  // the old bytes are written back and false is returned so that a full
+  // rewrite is tried; damaged is set if writing them back fails too.
+  bool patch_file(bool &damaged) {
+    TextBuffer &text = editbuffer.text;
+    struct stat info;
+    if (!on_disk || stat(filename.c_str(), &info) != 0
+        || info.st_dev != disk_info.st_dev
+        || info.st_ino != disk_info.st_ino
+        || info.st_size != text.size()
+        || text.size() != text.clean_size()
+        || info.st_mtim.tv_sec != disk_info.st_mtim.tv_sec
+        || info.st_mtim.tv_nsec != disk_info.st_mtim.tv_nsec) {
+      return false;
+    }
+    TextBuffer::Range changed = text.changed_range();
+    std::size_t length = changed.end - changed.begin;
+    if (length > LOAD_CHUNK || length > text.size() / 2) {
+      return false;
+    }
+    int fd = open(filename.c_str(), O_RDWR);
+    if (fd < 0) {
+      return false;
+    }
+    std::string patch = text.view(changed.begin, changed.end).str();
+    std::string old(length, '\0');
+    std::size_t written = 0;
+    bool ok = transfer(pread, fd, &old[0], length, changed.begin) == length;
+    if (ok) {
+      written = transfer(pwrite, fd, &patch[0], length, changed.begin);
+      ok = written == length && (!FEMTO_SYNC_ON_SAVE || fsync(fd) == 0);
+    }
+    // put back what was overwritten, so a full rewrite starts from the
+    // old contents
+    damaged = !ok && written > 0
+      && (transfer(pwrite, fd, &old[0], written, changed.begin) != written
+          || fsync(fd) != 0);
+    return close(fd) == 0 && ok;
+  }
+
+  // Read or write, with pread or pwrite, length bytes at the given
+  // offset of the file. Returns how many were, which is less than
+  // length if one fails or the file ends first.
+  template <typename Transfer>
+  static std::size_t transfer(Transfer call, int fd, char *data,
+                              std::size_t length, off_t offset) {
+    std::size_t done = 0;
+    while (done < length) {
+      ssize_t count = call(fd, data + done, length - done, offset + done);
+      if (count == 0 || (count < 0 && errno != EINTR)) {
+        break;
+      } else if (count > 0) {
+        done += count;
+      }
     }
-    return !modified;
+    return done;
   }
 };
 
 
 int main(int argc, char **argv) {
   std::string filename = "";
-  FemtoEditor::InputMode input_mode = FemtoEditor::FEMTO_INPUT_MODE;
-  if (argc > 1 && argv[1] == std::string("-r")) {
-    input_mode = FemtoEditor::RAW;
-    --argc;
-    ++argv;
-  } else if (argc > 1 && argv[1] == std::string("-t")) {
-    input_mode = FemtoEditor::TERMINAL;
-    --argc;
-    ++argv;
+  std::string program = argv[0];
+  FemtoEditor::Options options;
+  for (; argc > 1; --argc, ++argv) {
+    std::string arg = argv[1];
+    if (arg == "-r") {
+      options.input_mode = FemtoEditor::RAW;
+    } else if (arg == "-t") {
+      options.input_mode = FemtoEditor::TERMINAL;
+    } else if (arg == "-p") {
+      options.show_profile = true;
+    } else if (arg == "-k" && argc > 2) {
+      options.key_file = argv[2];
+      --argc;
+      ++argv;
+    } else if (arg == "-d" && argc > 2) {
+      options.trace_file = argv[2];
+      --argc;
+      ++argv;
+    } else if (arg == "-l" && argc > 2) {
+      options.log_file = argv[2];
+      --argc;
+      ++argv;
+    } else {
+      break;
+    }
   }
   if (argc > 1 && argv[1][0] == '-') {
     std::string arg = argv[1];
@@ -1003,10 +1300,19 @@ int main(int argc, char **argv) {
     info += FemtoEditor::version;
     info += "\nAuthor: Amir Kamil";
     std::string usage = "Usage: ";
-    usage += argv[0];
-    usage += " [-r|-t] [filename]";
+    usage += program;
+    usage += " [-r|-t] [-p] [-d tracefile] [-l logfile] [-k keyfile]";
+    usage += " [filename]";
     usage += "\n\t-r\tenable raw input mode";
     usage += "\n\t-t\tenable terminal input mode";
+    usage += "\n\t-p\tshow frame times, and report timings on exit";
+    usage += "\n\t-d\twrite a trace of timings to tracefile, in the";
+    usage += "\n\t\tChrome trace event format";
+    usage += "\n\t-l\trecord the keys typed, and when, in logfile, for";
+    usage += "\n\t\treplay.exe to replay";
+    usage += "\n\t-k\treplay the keys in keyfile without a terminal and";
+    usage += "\n\t\treport how long they took (LINES and COLUMNS set";
+    usage += "\n\t\tthe screen size)";
     if (arg != "-h" && arg != "-v" && arg != "--help") {
       std::cout << "Unknown option " << arg << "\n";
       exit_value = 1;
@@ -1017,5 +1323,10 @@ int main(int argc, char **argv) {
   if (argc > 1) {
     filename = argv[1];
   }
-  FemtoEditor fedit(filename, input_mode);
+  try {
+    FemtoEditor fedit(filename, options);
+  } catch (const std::runtime_error &error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
 }
@@ -13,17 +13,15 @@
 
 using namespace std;
 
-// REQUIRES: start >= 0 and end <= text.size()
 // MODIFIES: cout
-// EFFECTS:  Prints out the characters from text in the range [start,
-//           end) to cout, replacing newline characters with the \n
-//           escape sequence.
-void print_range(string text, int start, int end) {
-  for (int i = start; i < end; ++i) {
-    if (text[i] == '\n') {
+// EFFECTS:  Prints out the characters in the given view to cout,
+//           replacing newline characters with the \n escape sequence.
+void print_range(const TextBuffer::View &text) {
+  for (char c : text) {
+    if (c == '\n') {
       cout << "\\n";
     } else {
-      cout << text[i];
+      cout << c;
     }
   }
 }
@@ -34,11 +32,10 @@ void print_range(string text, int start, int end) {
 //           the cursor position is signified by a | character. Also
 //           prints out the cursor row and column.
 void visualize_buffer(TextBuffer &buffer) {
-  string text = buffer.stringify();
   int index = buffer.get_index();
-  print_range(text, 0, index);
+  print_range(buffer.view(0, index));
   cout << '|';
-  print_range(text, index, text.size());
+  print_range(buffer.view(index, buffer.size()));
   cout << "\t:(" << buffer.get_row() << "," << buffer.get_column()
        << " )\n";
 }
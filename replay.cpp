@@ -0,0 +1,227 @@
+/**
+ * Replay a key log recorded by FEMTO (femto.exe -l) into a TextBuffer
+ * and report how long each kind of buffer operation took.
+ *
+ * Keys are interpreted by FEMTO's own commands (Editor.hpp), including
+ * the keys typed at its prompts, but nothing is drawn and nothing is
+ * written, so the timings are those of the buffer alone. This turns
+ * the sessions users record into workloads for comparing buffer
+ * implementations.
+ * Paging depends on the height of the screen, which is taken from the
+ * LINES environment variable, or 24 by default, as femto.exe -k does.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "TextBuffer.hpp"
+#include "ByteScan.hpp"
+#include "Editor.hpp"
+#include "Histogram.hpp"
+#include "KeyBindings.hpp"
+#include "KeyLog.hpp"
+#include "MappedFile.hpp"
+#include "Profile.hpp"
+
+class KeyReplay : public Editor {
+public:
+  // Load the given file, if any, to replay the log on.
+  KeyReplay(const std::string &log_path, const std::string &filename_in)
+    : Editor(filename_in), log(log_path), profile(stage_names()),
+      has_lookahead(false), timing_key(false), exited(false) {
+    const char *lines = std::getenv("LINES");
+    rows = std::max(1, (lines ? std::atoi(lines) : DEFAULT_LINES)
+                       - BAR_LINES);
+    time_work(&profile,
+              {INSERT, REMOVE, MOVE, SEARCH, REPLACE, CUT, UNDO, SAVE});
+    if (!filename.empty()) {
+      load_file(filename);
+    }
+  }
+
+  // Replay the log to its end, or until it exits FEMTO.
+  void run() {
+    auto start = clock::now();
+    try {
+      while (handle_edit_input(read_key())) {
+        recenter(); // FEMTO renders after each key
+      }
+      exited = true;
+    } catch (const LogFinished &) {
+      // ran out of keys
+    }
+    finish_key();
+    replay_seconds =
+      std::chrono::duration<double>(clock::now() - start).count();
+  }
+
+  // Print the timings and a summary of the resulting buffer, whose
+  // checksum shows whether two replays of a log agree.
+  void report(std::ostream &os) const {
+    const Histogram &keys = profile.histogram(KEY);
+    os << "Replayed " << keys.count() << " keys, typed over "
+       << Histogram::format(last_time) << ", in "
+       << Histogram::format(replay_seconds)
+       << (exited ? " (exited)" : "") << "\n";
+    profile.print(os);
+    unsigned long long checksum = FNV_OFFSET;
+    for (char c : text.view()) {
+      checksum = (checksum ^ static_cast<unsigned char>(c)) * FNV_PRIME;
+    }
+    os << "Buffer: " << text.size() << " bytes, " << text.num_rows()
+       << " rows, checksum " << std::hex << checksum << std::dec
+       << std::endl;
+  }
+
+private:
+  using clock = Profile::clock;
+  static const int DEFAULT_LINES = 24; // height of the screen
+  static const int BAR_LINES = 4; // lines of the screen that hold bars
+  static const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+  static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+  // Kinds of work that are timed. A key is timed from when it is read
+  // until the next key is read, so it includes the work it caused.
+  enum Stage {
+    KEY, LOAD, INSERT, REMOVE, MOVE, SEARCH, REPLACE, CUT, UNDO, SAVE
+  };
+
+  // Return the names of the stages, in order.
+  static std::vector<std::string> stage_names() {
+    return {"key", "load", "insert", "remove", "move", "search",
+            "replace", "cut", "undo", "save"};
+  }
+
+  // Thrown when the log runs out of keys.
+  struct LogFinished {};
+
+  KeyLogReader log;
+  Profile profile;
+  KeyEvent event;       // the event read last
+  bool has_lookahead;   // whether event has not been handled yet
+  clock::time_point key_time;
+  bool timing_key;
+  bool exited;          // whether the log exited FEMTO
+  double last_time = 0; // when the last event was typed
+  double replay_seconds = 0;
+  int rows;             // rows of text on the screen
+  std::size_t saved_bytes = 0; // what saving would have written
+
+  // Handle a key in the text. A RECOVERED key, which FEMTO logs when it
+  // restores a recovery file, replaces the text with the text logged
+  // after it.
+  bool handle_edit_input(int c) override {
+    if (c == KeyBindings::RECOVERED) {
+      Profile::Timer timer(&profile, LOAD);
+      text.clear();
+      append_text(read_text());
+      text.seek_index(0);
+      set_modified();
+      return true;
+    }
+    return Editor::handle_edit_input(c);
+  }
+
+  // Read the whole file into the buffer. A missing file leaves the
+  // buffer empty.
+  void load_file(const std::string &path) {
+    Profile::Timer timer(&profile, LOAD);
+    try {
+      MappedFile file(path);
+      append_text(file.view());
+    } catch (const std::runtime_error &) {
+      // a new file starts out empty
+    }
+    text.seek_index(0);
+  }
+
+  // Append the contents of a file to the buffer, converting CR and CRLF
+  // to LF as FEMTO does.
+  void append_text(std::string_view contents) {
+    std::string scratch;
+    bool after_cr = false;
+    text.append(ByteScan::normalize_newlines(
+                  contents.data(), contents.data() + contents.size(),
+                  scratch, after_cr));
+  }
+
+  // Read the next event, throwing LogFinished at the end of the log.
+  const KeyEvent & next_event() {
+    if (!has_lookahead && !log.next(event)) {
+      throw LogFinished();
+    }
+    has_lookahead = false;
+    last_time = event.time;
+    return event;
+  }
+
+  // Read the next key, skipping text that no key asked for.
+  int read_key() override {
+    finish_key();
+    while (next_event().key == KeyEvent::TEXT);
+    key_time = clock::now();
+    timing_key = true;
+    return event.key;
+  }
+
+  // Read the text logged with the current key, or return an empty
+  // string if there is none.
+  std::string read_text() {
+    if (!log.next(event)) {
+      return "";
+    } else if (event.key != KeyEvent::TEXT) {
+      has_lookahead = true; // a key, for read_key
+      return "";
+    }
+    last_time = event.time;
+    return event.text;
+  }
+
+  // Read the text logged with a paste key.
+  std::string read_paste() override {
+    return read_text();
+  }
+
+  // Record the time taken by the key being timed, if any.
+  void finish_key() {
+    if (timing_key) {
+      profile.record(KEY, key_time, clock::now());
+      timing_key = false;
+    }
+  }
+
+  // Rather than writing the file, copy out the whole buffer, as
+  // writing it would.
+  bool write_file(const std::string &) override {
+    saved_bytes += text.stringify().size();
+    return true;
+  }
+
+  // Return the number of rows of text on the screen, as FEMTO has.
+  int canvas_rows() const override {
+    return rows;
+  }
+};
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 3 || argv[1][0] == '-') {
+    std::cout << "Usage: " << argv[0] << " logfile [filename]\n"
+              << "\tReplays a key log recorded with femto.exe -l on the"
+              << " given file\n\tand reports how long the buffer took."
+              << std::endl;
+    return argc == 2 && argv[1] == std::string("-h") ? 0 : 1;
+  }
+  try {
+    KeyReplay replay(argv[1], argc > 2 ? argv[2] : "");
+    replay.run();
+    replay.report(std::cout);
+  } catch (const std::runtime_error &error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+}